@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cmath>
+#include <tuple>
+#include <vector>
+#include "Dijkstra.hpp"
+#include "Coordinate.hpp"
+#include "Landmarks.hpp"
+
+// A heuristic estimates the remaining distance from a vertex to the target set with set_target(). To keep A*
+// exact it must never overestimate and must be consistent (h(u) <= weight(u, w) + h(w)); all of the ones
+// below are. is_zero lets the search drop the heuristic entirely at compile time.
+
+// No estimate at all: A* with this heuristic is exactly Dijkstra
+struct ZeroHeuristic {
+    static constexpr bool is_zero = true;
+    void set_target(Vertex) {}
+    double operator()(Vertex) const { return 0; }
+};
+
+// Straight-line distance between per-vertex planar coordinates times a scale, which must be at most the
+// smallest weight per unit of length over all edges (see admissible_scale).
+class EuclideanHeuristic {
+    private:
+        const Coordinate* coordinates;
+        double scale;
+        Coordinate target = {0, 0};
+    public:
+        static constexpr bool is_zero = false;
+
+        EuclideanHeuristic(const Coordinate* coordinates, double scale) : coordinates(coordinates), scale(scale) {}
+        EuclideanHeuristic(const std::vector<Coordinate>& coordinates, double scale) : EuclideanHeuristic(coordinates.data(), scale) {}
+
+        static double length(const Coordinate& a, const Coordinate& b) {
+            return std::hypot(a.x - b.x, a.y - b.y);
+        }
+
+        void set_target(Vertex t) { target = coordinates[t]; }
+        double operator()(Vertex v) const { return scale * length(coordinates[v], target); }
+};
+
+// Great-circle distance in meters between (longitude, latitude) coordinates in degrees, times a scale in
+// weight units per meter (see admissible_scale).
+class HaversineHeuristic {
+    private:
+        const Coordinate* coordinates;
+        double scale;
+        Coordinate target = {0, 0};
+    public:
+        static constexpr bool is_zero = false;
+
+        HaversineHeuristic(const Coordinate* coordinates, double scale) : coordinates(coordinates), scale(scale) {}
+        HaversineHeuristic(const std::vector<Coordinate>& coordinates, double scale) : HaversineHeuristic(coordinates.data(), scale) {}
+
+        static double length(const Coordinate& a, const Coordinate& b) {
+            const double radians = 3.14159265358979323846 / 180.0;
+            const double earth_radius = 6371000.0;
+            double dlat = (b.y - a.y) * radians;
+            double dlon = (b.x - a.x) * radians;
+            double h = std::sin(dlat / 2) * std::sin(dlat / 2) +
+                       std::cos(a.y * radians) * std::cos(b.y * radians) * std::sin(dlon / 2) * std::sin(dlon / 2);
+            return 2 * earth_radius * std::asin(std::sqrt(h < 1 ? h : 1));
+        }
+
+        void set_target(Vertex t) { target = coordinates[t]; }
+        double operator()(Vertex v) const { return scale * length(coordinates[v], target); }
+};
+
+// ALT: the best landmark triangle-inequality bound
+class LandmarkHeuristic {
+    private:
+        const Landmarks* landmarks;
+        Vertex target = 0;
+    public:
+        static constexpr bool is_zero = false;
+
+        LandmarkHeuristic(const Landmarks& landmarks) : landmarks(&landmarks) {}
+
+        void set_target(Vertex t) { target = t; }
+        double operator()(Vertex v) const { return landmarks->lower_bound(v, target); }
+};
+
+// The largest scale for which a coordinate heuristic stays admissible: the smallest weight / length over all
+// edges. HEURISTIC is EuclideanHeuristic or HaversineHeuristic. Zero-length edges are ignored.
+template <typename HEURISTIC, typename GRAPH>
+double admissible_scale(const GRAPH& G, const std::vector<Coordinate>& coordinates) {
+    double scale = 1.0 / 0.0;
+    for (Vertex u = 0; u < G.num_vertices(); u++) {
+        G.for_each_neighbor(u, [&](Vertex w, Weight weight) {
+            double length = HEURISTIC::length(coordinates[u], coordinates[w]);
+            if (length > 0 and weight / length < scale) scale = weight / length;
+        });
+    }
+    return scale == 1.0 / 0.0 ? 0 : scale;
+}
+
+// Goal-directed Dijkstra: the heap is keyed by dist + heuristic, so with a good estimate the search heads for
+// 'end' instead of growing a ball around v. Returns dist/prev like dijkstra(); with a consistent heuristic
+// dist[end] is exact once the search stops.
+template <unsigned ARITY = 4, typename GRAPH, typename HEURISTIC>
+std::tuple<std::vector<double>, std::vector<Vertex>> astar(const GRAPH& G, Vertex v, Vertex end, HEURISTIC heuristic, SearchStats& stats) {
+    if constexpr (HEURISTIC::is_zero) {
+        return dijkstra<ARITY>(G, v, end, stats);
+    }
+    else {
+        double inf = 1.0 / 0.0;
+        std::size_t n = G.num_vertices();
+        std::vector<double> dist(n, inf);
+        std::vector<Vertex> prev(n, NO_VERTEX);
+        if (v >= n or end >= n) { return std::tuple(dist, prev); }
+
+        ScopedTimer timer(stats.search_seconds);
+        heuristic.set_target(end);
+        dist[v] = 0;
+        prev[v] = v;
+
+        IndexedHeap<double, ARITY> pq(n);
+        pq.push(v, heuristic(v));
+        stats_count(stats.pushes);
+        while (!pq.empty()) {
+            Vertex u = pq.pop();
+            stats_count(stats.pops);
+            stats_count(stats.settled);
+            if (u == end) break;
+            double du = dist[u];
+            G.for_each_neighbor(u, [&](Vertex w, Weight weight) {
+                stats_count(stats.relaxations);
+                double candidate = du + weight;
+                if (candidate < dist[w]) {
+                    dist[w] = candidate;
+                    prev[w] = u;
+                    stats_count_push(stats, pq, w);
+                    pq.push_or_decrease(w, candidate + heuristic(w));
+                }
+            });
+        }
+        return std::tuple(dist, prev);
+    }
+}
+
+template <unsigned ARITY = 4, typename GRAPH, typename HEURISTIC>
+std::tuple<std::vector<double>, std::vector<Vertex>> astar(const GRAPH& G, Vertex v, Vertex end, HEURISTIC heuristic) {
+    SearchStats stats;
+    return astar<ARITY>(G, v, end, heuristic, stats);
+}
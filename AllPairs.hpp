@@ -0,0 +1,399 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "IntegerDijkstra.hpp"
+#include "MappedFile.hpp"
+#include "MappedGraph.hpp"
+#include "SimdRelaxation.hpp"
+#include "ThreadPool.hpp"
+
+// All-pairs distance tables: n x n row-major 32-bit entries, out[s * n + t] being the distance from s to t.
+// Unreachable pairs hold TABLE_INFINITY. It is 2^31 - 1 rather than 2^32 - 1 so that a finite entry plus any
+// entry still fits in 32 bits and Floyd-Warshall can add and take minimums without overflow checks; distances
+// of TABLE_INFINITY or more read as unreachable.
+constexpr std::uint32_t TABLE_INFINITY = std::numeric_limits<std::uint32_t>::max() >> 1;
+
+enum class AllPairsMethod { AUTO, DIJKSTRA, FLOYD_WARSHALL };
+
+inline const char* all_pairs_method_name(AllPairsMethod method) {
+    if (method == AllPairsMethod::DIJKSTRA) return "dijkstra";
+    if (method == AllPairsMethod::FLOYD_WARSHALL) return "floyd_warshall";
+    return "auto";
+}
+
+// Measured per pair of vertices on one core: Floyd-Warshall about n / 10 ns (n steps of 16 lanes each, at
+// roughly 6 ns per 64-entry row update) and repeated Dijkstra about 80 + 3 * m / n ns (queue work per vertex
+// plus one relaxation per arc). So Floyd-Warshall is the faster one up to n = 800 + 30 * m / n: every graph up
+// to a few hundred vertices, and beyond that only dense ones.
+inline AllPairsMethod choose_all_pairs_method(std::size_t num_vertices, std::size_t num_arcs) {
+    double n = double(num_vertices), degree = n > 0 ? double(num_arcs) / n : 0;
+    return n <= 800 + 30 * degree ? AllPairsMethod::FLOYD_WARSHALL : AllPairsMethod::DIJKSTRA;
+}
+
+// 64 x 64 entries of 4 bytes: a tile row is four AVX-512 registers, and the tiles one update reads fit in L1/L2
+constexpr std::size_t FLOYD_WARSHALL_BLOCK = 64;
+
+// One Floyd-Warshall tile update: for every k in [k_first, k_end) and every row i in [i_first, i_end) with a
+// path to k, table[i][j] = min(table[i][j], table[i][k] + table[k][j]) for the 'width' columns from j_first.
+// table[i][k] is below TABLE_INFINITY when it is used, so no sum wraps around. A whole tile per call, so the
+// vector versions keep their loops inlined.
+using MinPlusTile = void (*)(std::uint32_t* table, std::size_t n, std::size_t i_first, std::size_t i_end, std::size_t j_first,
+                             std::size_t width, std::size_t k_first, std::size_t k_end);
+
+inline void min_plus_row(std::uint32_t* row, const std::uint32_t* through, std::uint32_t via, std::size_t count) {
+    for (std::size_t j = 0; j < count; j++) row[j] = std::min(row[j], through[j] + via);
+}
+
+inline void min_plus_tile_scalar(std::uint32_t* table, std::size_t n, std::size_t i_first, std::size_t i_end, std::size_t j_first,
+                                 std::size_t width, std::size_t k_first, std::size_t k_end) {
+    for (std::size_t k = k_first; k < k_end; k++) {
+        const std::uint32_t* through = table + k * n + j_first;
+        for (std::size_t i = i_first; i < i_end; i++) {
+            std::uint32_t via = table[i * n + k];
+            if (via < TABLE_INFINITY) min_plus_row(table + i * n + j_first, through, via, width);
+        }
+    }
+}
+
+#ifdef SHORTEST_PATH_X86
+__attribute__((target("avx2"))) inline void min_plus_tile_avx2(std::uint32_t* table, std::size_t n, std::size_t i_first, std::size_t i_end,
+                                                              std::size_t j_first, std::size_t width, std::size_t k_first, std::size_t k_end) {
+    for (std::size_t k = k_first; k < k_end; k++) {
+        const std::uint32_t* through = table + k * n + j_first;
+        for (std::size_t i = i_first; i < i_end; i++) {
+            std::uint32_t via = table[i * n + k];
+            if (via >= TABLE_INFINITY) continue;
+            std::uint32_t* row = table + i * n + j_first;
+            __m256i add = _mm256_set1_epi32(static_cast<int>(via));
+            std::size_t j = 0;
+            for (; j + 8 <= width; j += 8) {
+                __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + j));
+                __m256i candidate = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(through + j)), add);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + j), _mm256_min_epu32(current, candidate));
+            }
+            min_plus_row(row + j, through + j, via, width - j);
+        }
+    }
+}
+
+__attribute__((target("avx512f"))) inline void min_plus_tile_avx512(std::uint32_t* table, std::size_t n, std::size_t i_first, std::size_t i_end,
+                                                                   std::size_t j_first, std::size_t width, std::size_t k_first, std::size_t k_end) {
+    for (std::size_t k = k_first; k < k_end; k++) {
+        const std::uint32_t* through = table + k * n + j_first;
+        for (std::size_t i = i_first; i < i_end; i++) {
+            std::uint32_t via = table[i * n + k];
+            if (via >= TABLE_INFINITY) continue;
+            std::uint32_t* row = table + i * n + j_first;
+            __m512i add = _mm512_set1_epi32(static_cast<int>(via));
+            std::size_t j = 0;
+            for (; j + 16 <= width; j += 16) {
+                __m512i current = _mm512_loadu_si512(row + j);
+                __m512i candidate = _mm512_add_epi32(_mm512_loadu_si512(through + j), add);
+                // The masked form with an explicit source; the plain one starts from an undefined register
+                _mm512_storeu_si512(row + j, _mm512_mask_min_epu32(current, 0xffff, current, candidate));
+            }
+            min_plus_row(row + j, through + j, via, width - j);
+        }
+    }
+}
+#endif
+
+// The update of one full tile in the third phase, whose row and column tiles are final already. 'rows' is the
+// tile's first entry and 'via' the first entry of the same rows in the column tile, both with stride n;
+// 'through' is the row tile copied to depth x FLOYD_WARSHALL_BLOCK contiguous entries, so its rows do not
+// compete for the cache sets of the tile's own. Nothing the loop reads changes during it, so each row of
+// the tile stays in registers for the whole k loop and is stored once.
+using MinPlusBlock = void (*)(std::uint32_t* rows, const std::uint32_t* via, std::size_t n, std::size_t count, const std::uint32_t* through,
+                              std::size_t depth);
+
+inline void min_plus_block_scalar(std::uint32_t* rows, const std::uint32_t* via, std::size_t n, std::size_t count, const std::uint32_t* through,
+                                  std::size_t depth) {
+    for (std::size_t r = 0; r < count; r++) {
+        for (std::size_t k = 0; k < depth; k++) {
+            if (via[r * n + k] < TABLE_INFINITY) min_plus_row(rows + r * n, through + k * FLOYD_WARSHALL_BLOCK, via[r * n + k], FLOYD_WARSHALL_BLOCK);
+        }
+    }
+}
+
+#ifdef SHORTEST_PATH_X86
+__attribute__((target("avx2"))) inline void min_plus_block_avx2(std::uint32_t* rows, const std::uint32_t* via, std::size_t n, std::size_t count,
+                                                               const std::uint32_t* through, std::size_t depth) {
+    static_assert(FLOYD_WARSHALL_BLOCK == 64, "one tile row is eight AVX2 registers");
+    for (std::size_t r = 0; r < count; r++) {
+        __m256i* row = reinterpret_cast<__m256i*>(rows + r * n);
+        // Spelled out rather than an array, which GCC keeps in memory at -O2
+        __m256i b0 = _mm256_loadu_si256(row), b1 = _mm256_loadu_si256(row + 1), b2 = _mm256_loadu_si256(row + 2), b3 = _mm256_loadu_si256(row + 3);
+        __m256i b4 = _mm256_loadu_si256(row + 4), b5 = _mm256_loadu_si256(row + 5), b6 = _mm256_loadu_si256(row + 6), b7 = _mm256_loadu_si256(row + 7);
+        for (std::size_t k = 0; k < depth; k++) {
+            std::uint32_t v = via[r * n + k];
+            if (v >= TABLE_INFINITY) continue;
+            __m256i add = _mm256_set1_epi32(static_cast<int>(v));
+            const __m256i* t = reinterpret_cast<const __m256i*>(through + k * FLOYD_WARSHALL_BLOCK);
+            b0 = _mm256_min_epu32(b0, _mm256_add_epi32(_mm256_loadu_si256(t), add));
+            b1 = _mm256_min_epu32(b1, _mm256_add_epi32(_mm256_loadu_si256(t + 1), add));
+            b2 = _mm256_min_epu32(b2, _mm256_add_epi32(_mm256_loadu_si256(t + 2), add));
+            b3 = _mm256_min_epu32(b3, _mm256_add_epi32(_mm256_loadu_si256(t + 3), add));
+            b4 = _mm256_min_epu32(b4, _mm256_add_epi32(_mm256_loadu_si256(t + 4), add));
+            b5 = _mm256_min_epu32(b5, _mm256_add_epi32(_mm256_loadu_si256(t + 5), add));
+            b6 = _mm256_min_epu32(b6, _mm256_add_epi32(_mm256_loadu_si256(t + 6), add));
+            b7 = _mm256_min_epu32(b7, _mm256_add_epi32(_mm256_loadu_si256(t + 7), add));
+        }
+        _mm256_storeu_si256(row, b0);
+        _mm256_storeu_si256(row + 1, b1);
+        _mm256_storeu_si256(row + 2, b2);
+        _mm256_storeu_si256(row + 3, b3);
+        _mm256_storeu_si256(row + 4, b4);
+        _mm256_storeu_si256(row + 5, b5);
+        _mm256_storeu_si256(row + 6, b6);
+        _mm256_storeu_si256(row + 7, b7);
+    }
+}
+
+__attribute__((target("avx512f"))) inline void min_plus_block_avx512(std::uint32_t* rows, const std::uint32_t* via, std::size_t n, std::size_t count,
+                                                                    const std::uint32_t* through, std::size_t depth) {
+    static_assert(FLOYD_WARSHALL_BLOCK == 64, "one tile row is four AVX-512 registers");
+    for (std::size_t r = 0; r < count; r++) {
+        std::uint32_t* row = rows + r * n;
+        __m512i b0 = _mm512_loadu_si512(row), b1 = _mm512_loadu_si512(row + 16), b2 = _mm512_loadu_si512(row + 32), b3 = _mm512_loadu_si512(row + 48);
+        for (std::size_t k = 0; k < depth; k++) {
+            std::uint32_t v = via[r * n + k];
+            if (v >= TABLE_INFINITY) continue;
+            __m512i add = _mm512_set1_epi32(static_cast<int>(v));
+            const std::uint32_t* t = through + k * FLOYD_WARSHALL_BLOCK;
+            // Masked minimums with an explicit source, as in min_plus_tile_avx512
+            b0 = _mm512_mask_min_epu32(b0, 0xffff, b0, _mm512_add_epi32(_mm512_loadu_si512(t), add));
+            b1 = _mm512_mask_min_epu32(b1, 0xffff, b1, _mm512_add_epi32(_mm512_loadu_si512(t + 16), add));
+            b2 = _mm512_mask_min_epu32(b2, 0xffff, b2, _mm512_add_epi32(_mm512_loadu_si512(t + 32), add));
+            b3 = _mm512_mask_min_epu32(b3, 0xffff, b3, _mm512_add_epi32(_mm512_loadu_si512(t + 48), add));
+        }
+        _mm512_storeu_si512(row, b0);
+        _mm512_storeu_si512(row + 16, b1);
+        _mm512_storeu_si512(row + 32, b2);
+        _mm512_storeu_si512(row + 48, b3);
+    }
+}
+#endif
+
+// The tile update for 'level', or for the best level below it that this CPU supports
+inline MinPlusTile min_plus_tile(SimdLevel level) {
+    if (static_cast<int>(level) > static_cast<int>(best_simd_level())) level = best_simd_level();
+#ifdef SHORTEST_PATH_X86
+    if (level == SimdLevel::AVX512) return min_plus_tile_avx512;
+    if (level == SimdLevel::AVX2) return min_plus_tile_avx2;
+#endif
+    return min_plus_tile_scalar;
+}
+
+inline MinPlusBlock min_plus_block(SimdLevel level) {
+    if (static_cast<int>(level) > static_cast<int>(best_simd_level())) level = best_simd_level();
+#ifdef SHORTEST_PATH_X86
+    if (level == SimdLevel::AVX512) return min_plus_block_avx512;
+    if (level == SimdLevel::AVX2) return min_plus_block_avx2;
+#endif
+    return min_plus_block_scalar;
+}
+
+// Floyd-Warshall on the table in place, in square tiles. For every diagonal tile kb, in three phases: the
+// diagonal tile on its own, then the other tiles of its row and column (each needs only itself and the
+// diagonal), then all remaining tiles (each needs only the finished row and column tile), the last two phases
+// spread over the pool. The first two are the plain k-i-j loop with the j loop in vector lanes
+// (min_plus_tile); the third, which is nearly all of the work, keeps tile rows in registers (min_plus_block).
+inline void floyd_warshall(std::uint32_t* table, std::size_t n, ThreadPool& pool, SimdLevel level = best_simd_level()) {
+    MinPlusTile tile = min_plus_tile(level);
+    MinPlusBlock block = min_plus_block(level);
+    const std::size_t B = FLOYD_WARSHALL_BLOCK;
+    if (n == 0) return;
+    std::size_t blocks = (n + B - 1) / B;
+    auto update = [&](std::size_t ib, std::size_t jb, std::size_t kb) {
+        std::size_t j_first = jb * B;
+        tile(table, n, ib * B, std::min(n, (ib + 1) * B), j_first, std::min(n, j_first + B) - j_first, kb * B, std::min(n, (kb + 1) * B));
+    };
+    std::vector<std::vector<std::uint32_t>> packed(pool.size(), std::vector<std::uint32_t>(B * B));
+    for (std::size_t kb = 0; kb < blocks; kb++) {
+        std::size_t k_first = kb * B, depth = std::min(n, k_first + B) - k_first;
+        update(kb, kb, kb);
+        pool.parallel_for(0, 2 * (blocks - 1), [&](std::size_t t, unsigned) {
+            std::size_t other = t / 2 < kb ? t / 2 : t / 2 + 1;
+            if (t % 2 == 0) update(kb, other, kb);
+            else update(other, kb, kb);
+        }, 1);
+        // Column by column, so one packed row tile serves every tile below it
+        pool.parallel_for(0, blocks - 1, [&](std::size_t t, unsigned thread) {
+            std::size_t jb = t < kb ? t : t + 1, j_first = jb * B;
+            if (j_first + B > n) {
+                for (std::size_t ib = 0; ib < blocks; ib++) {
+                    if (ib != kb) update(ib, jb, kb);
+                }
+                return;
+            }
+            std::uint32_t* through = packed[thread].data();
+            for (std::size_t k = 0; k < depth; k++) std::copy(table + (k_first + k) * n + j_first, table + (k_first + k) * n + j_first + B, through + k * B);
+            for (std::size_t ib = 0; ib < blocks; ib++) {
+                if (ib == kb) continue;
+                std::size_t i_first = ib * B;
+                block(table + i_first * n + j_first, table + i_first * n + k_first, n, std::min(n, i_first + B) - i_first, through, depth);
+            }
+        }, 1);
+    }
+}
+
+// Fills out (n * n entries, see TABLE_INFINITY) with the distances between all pairs of vertices of G, directed
+// or not. DIJKSTRA runs integer_dijkstra from every vertex, one source per task; FLOYD_WARSHALL starts from the
+// shortest arc between every pair and runs floyd_warshall; AUTO picks by choose_all_pairs_method.
+template <typename GRAPH>
+void all_pairs(const GRAPH& G, std::uint32_t* out, ThreadPool& pool, AllPairsMethod method = AllPairsMethod::AUTO) {
+    std::size_t n = G.num_vertices();
+    if (method == AllPairsMethod::AUTO) {
+        std::vector<std::size_t> arcs(pool.size(), 0);
+        pool.parallel_for(0, n, [&](std::size_t u, unsigned thread) {
+            G.for_each_neighbor(u, [&](Vertex, Weight) { arcs[thread]++; });
+        }, 1024);
+        std::size_t m = 0;
+        for (std::size_t count : arcs) m += count;
+        method = choose_all_pairs_method(n, m);
+    }
+
+    if (method == AllPairsMethod::DIJKSTRA) {
+        std::vector<RadixHeap> queues(pool.size(), RadixHeap(n));
+        pool.parallel_for(0, n, [&](std::size_t s, unsigned thread) {
+            SearchStats stats;
+            auto [dist, prev] = integer_dijkstra(G, s, NO_VERTEX, queues[thread], stats);
+            std::uint32_t* row = out + s * n;
+            for (Vertex t = 0; t < n; t++) row[t] = static_cast<std::uint32_t>(std::min<Weight>(dist[t], TABLE_INFINITY));
+        }, 1);
+        return;
+    }
+    if (method != AllPairsMethod::FLOYD_WARSHALL) throw std::runtime_error("Unknown all-pairs method");
+
+    pool.parallel_for(0, n, [&](std::size_t u, unsigned) {
+        std::uint32_t* row = out + u * n;
+        std::fill(row, row + n, TABLE_INFINITY);
+        G.for_each_neighbor(u, [&](Vertex w, Weight weight) {
+            row[w] = static_cast<std::uint32_t>(std::min<Weight>(row[w], weight));
+        });
+        row[u] = 0;
+    }, 64);
+    floyd_warshall(out, n, pool);
+}
+
+template <typename GRAPH>
+std::vector<std::uint32_t> all_pairs(const GRAPH& G, AllPairsMethod method = AllPairsMethod::AUTO, unsigned threads = 0) {
+    ThreadPool pool(threads);
+    std::vector<std::uint32_t> table(G.num_vertices() * G.num_vertices());
+    all_pairs(G, table.data(), pool, method);
+    return table;
+}
+
+// On-disk layout of a distance table: TableFileHeader, then the n * n uint32_t entries row by row from a
+// 64-byte aligned offset, so a reader maps the file and indexes it in place (see MappedDistanceTable)
+constexpr char TABLE_FILE_MAGIC[8] = {'S', 'P', 'T', 'A', 'B', 'L', 'E', '\0'};
+constexpr std::uint32_t TABLE_FILE_VERSION = 1;
+
+struct TableFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t num_vertices;
+    std::uint64_t entries_offset;
+    std::uint64_t file_size;
+};
+
+inline void write_distance_table(const std::string& path, const std::uint32_t* table, std::size_t n) {
+    TableFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TABLE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TABLE_FILE_VERSION;
+    header.byte_order = GRAPH_FILE_BYTE_ORDER;
+    header.num_vertices = n;
+    header.entries_offset = align_up(sizeof(TableFileHeader), GRAPH_FILE_ALIGNMENT);
+    header.file_size = header.entries_offset + std::uint64_t(n) * n * sizeof(std::uint32_t);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) { throw std::runtime_error("Cannot open " + path + " for writing"); }
+    static const char zeros[GRAPH_FILE_ALIGNMENT] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(zeros, header.entries_offset - sizeof(header));
+    out.write(reinterpret_cast<const char*>(table), std::uint64_t(n) * n * sizeof(std::uint32_t));
+    if (!out) { throw std::runtime_error("Failed writing " + path); }
+}
+
+// Computes the table straight into a new table file through a writable shared mapping, so a table larger than
+// memory is paged out by the kernel instead of being built on the heap and then written out
+template <typename GRAPH>
+void all_pairs_file(const GRAPH& G, const std::string& path, ThreadPool& pool, AllPairsMethod method = AllPairsMethod::AUTO) {
+    std::uint64_t n = G.num_vertices();
+    TableFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TABLE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TABLE_FILE_VERSION;
+    header.byte_order = GRAPH_FILE_BYTE_ORDER;
+    header.num_vertices = n;
+    header.entries_offset = align_up(sizeof(TableFileHeader), GRAPH_FILE_ALIGNMENT);
+    header.file_size = header.entries_offset + n * n * sizeof(std::uint32_t);
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { throw std::runtime_error("Cannot open " + path + " for writing"); }
+    if (ftruncate(fd, static_cast<off_t>(header.file_size)) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot size " + path);
+    }
+    void* base = mmap(nullptr, header.file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) { throw std::runtime_error("Cannot map " + path); }
+    std::memcpy(base, &header, sizeof(header));
+    try {
+        all_pairs(G, reinterpret_cast<std::uint32_t*>(static_cast<char*>(base) + header.entries_offset), pool, method);
+    }
+    catch (...) {
+        munmap(base, header.file_size);
+        throw;
+    }
+    munmap(base, header.file_size);
+}
+
+// A read-only distance table used in place from its file; lookups only fault in the rows they touch
+class MappedDistanceTable {
+    private:
+        MappedFile file;
+        const TableFileHeader* header = nullptr;
+        const std::uint32_t* entries = nullptr;
+
+    public:
+        MappedDistanceTable(const std::string& path, bool prefault = false) : file(path, prefault) {
+            if (file.size() < sizeof(TableFileHeader)) {
+                throw std::runtime_error(path + " is too small to be a distance table");
+            }
+            header = reinterpret_cast<const TableFileHeader*>(file.data());
+            if (std::memcmp(header->magic, TABLE_FILE_MAGIC, sizeof(header->magic)) != 0) {
+                throw std::runtime_error(path + " is not a distance table");
+            }
+            if (header->version != TABLE_FILE_VERSION or header->byte_order != GRAPH_FILE_BYTE_ORDER) {
+                throw std::runtime_error(path + " has an unsupported version or byte order");
+            }
+            if (header->file_size != file.size()) {
+                throw std::runtime_error(path + " is truncated");
+            }
+            std::uint64_t n = header->num_vertices;
+            if ((n != 0 and n > std::numeric_limits<std::uint64_t>::max() / n) or
+                !file_section_fits(header->entries_offset, n * n, sizeof(std::uint32_t), sizeof(TableFileHeader), file.size())) {
+                throw std::runtime_error(path + " has entries outside the file");
+            }
+            entries = reinterpret_cast<const std::uint32_t*>(file.data() + header->entries_offset);
+        }
+
+        std::size_t num_vertices() const { return header->num_vertices; }
+
+        // TABLE_INFINITY if t cannot be reached from s
+        std::uint32_t get(Vertex s, Vertex t) const { return entries[s * header->num_vertices + t]; }
+        const std::uint32_t* row(Vertex s) const { return entries + s * header->num_vertices; }
+};
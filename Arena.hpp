@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Monotonic bump allocator: memory comes from large blocks and is only given back all at once when the
+// arena dies. Many small per-vertex arrays then cost one pointer bump each instead of a malloc, carry no
+// per-allocation header, and sit next to each other in memory in the order they were made. Not thread-safe.
+class Arena {
+    private:
+        struct Block {
+            std::unique_ptr<char[]> data;
+            std::size_t size;
+        };
+
+        std::vector<Block> blocks;
+        char* cursor = nullptr;
+        char* limit = nullptr;
+        std::size_t block_size;
+        std::size_t reserved = 0;
+
+    public:
+        Arena(std::size_t block_size = 1 << 20) : block_size(block_size) {}
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+            std::uintptr_t at = (reinterpret_cast<std::uintptr_t>(cursor) + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+            if (cursor == nullptr or at + bytes > reinterpret_cast<std::uintptr_t>(limit)) {
+                // Oversized requests get a block of their own, so the current block is not wasted on them
+                std::size_t size = std::max(block_size, bytes + alignment);
+                blocks.push_back(Block{std::unique_ptr<char[]>(new char[size]), size});
+                reserved += size;
+                char* base = blocks.back().data.get();
+                if (size > block_size) {
+                    return reinterpret_cast<void*>((reinterpret_cast<std::uintptr_t>(base) + alignment - 1) & ~(std::uintptr_t(alignment) - 1));
+                }
+                cursor = base;
+                limit = base + size;
+                at = (reinterpret_cast<std::uintptr_t>(cursor) + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+            }
+            cursor = reinterpret_cast<char*>(at + bytes);
+            return reinterpret_cast<void*>(at);
+        }
+
+        // Bytes taken from the system so far
+        std::size_t bytes_reserved() const { return reserved; }
+};
+
+// Standard allocator on top of an Arena, for containers that are built once and then only read. Freeing is
+// a no-op. Without an arena it falls back to the heap, and copies of a container always go to the heap so a
+// copy never depends on the lifetime of the original's arena.
+template <typename T>
+class ArenaAllocator {
+    private:
+        template <typename U> friend class ArenaAllocator;
+        Arena* arena;
+
+    public:
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        ArenaAllocator(Arena* arena = nullptr) noexcept : arena(arena) {}
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+        T* allocate(std::size_t count) {
+            if (arena == nullptr) return static_cast<T*>(::operator new(count * sizeof(T)));
+            return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* p, std::size_t) noexcept {
+            if (arena == nullptr) ::operator delete(p);
+        }
+
+        ArenaAllocator select_on_container_copy_construction() const { return ArenaAllocator(); }
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+        template <typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "SignedGraph.hpp"
+#include "IntegerDijkstra.hpp"
+#include "ThreadPool.hpp"
+
+// Unreachable
+constexpr SignedWeight SIGNED_INFINITE_DISTANCE = std::numeric_limits<SignedWeight>::max();
+// Reachable through a negative cycle, so there is no shortest path
+constexpr SignedWeight NEGATIVE_INFINITE_DISTANCE = std::numeric_limits<SignedWeight>::min();
+
+struct BellmanFordResult {
+    std::vector<SignedWeight> dist;
+    std::vector<Vertex> prev;              // NO_VERTEX where dist is infinite either way
+    std::vector<Vertex> negative_cycle;    // in arc order, the last vertex has an arc to the first; empty if none
+    std::size_t rounds = 0;
+};
+
+// A cycle of the prev pointers in arc order, or nothing. Each vertex has one prev, so one walk per unvisited
+// vertex finds every cycle in O(n). Any such cycle has negative weight: every arc on it was tight when it was
+// taken, and the tail's dist has only gone down since, so the last arc closing it was strictly improving.
+// 'root' points at itself without being a cycle unless a negative self loop lowered its dist.
+inline std::vector<Vertex> prev_cycle(const std::vector<Vertex>& prev, const std::vector<SignedWeight>& dist, Vertex root) {
+    std::size_t n = prev.size();
+    std::vector<Vertex> walk(n, NO_VERTEX);
+    for (Vertex start = 0; start < n; start++) {
+        for (Vertex v = start; v != NO_VERTEX;) {
+            if (walk[v] == start) {
+                std::vector<Vertex> cycle(1, v);
+                for (Vertex u = prev[v]; u != v; u = prev[u]) cycle.push_back(u);
+                std::reverse(cycle.begin(), cycle.end());
+                return cycle;
+            }
+            if (walk[v] != NO_VERTEX) break;
+            walk[v] = start;
+            if (v == root and prev[v] == v and dist[v] >= 0) break;
+            v = prev[v];
+        }
+    }
+    return {};
+}
+
+// Frontier-based relaxation rounds (the SPFA idea in synchronous rounds): each round relaxes the out-arcs of
+// exactly the vertices whose dist changed in the round before, and the search ends as soon as a round changes
+// nothing. The frontier is split over the pool; threads read the dist of the previous round and only collect
+// proposals, which are then applied in one pass, so dist and prev always change together and prev_cycle can
+// trust them. After round r every dist is the shortest walk of at most r arcs, so a change in round n or later
+// means a negative cycle; the rounds then go on until it shows up in prev, and everything reachable from that
+// frontier gets NEGATIVE_INFINITE_DISTANCE. 'root' is the source, or NO_VERTEX for Johnson's virtual source.
+inline void bellman_ford_rounds(const SignedGraph& G, BellmanFordResult& result, std::vector<Vertex> frontier, Vertex root, ThreadPool& pool) {
+    struct Proposal {
+        Vertex vertex;
+        SignedWeight dist;
+        Vertex from;
+    };
+    std::size_t n = G.num_vertices();
+    std::vector<SignedWeight>& dist = result.dist;
+    std::vector<Vertex>& prev = result.prev;
+    std::vector<std::vector<Proposal>> proposals(pool.size());
+    std::vector<char> changed(n, 0);
+    std::vector<Vertex> next, affected;
+
+    while (!frontier.empty()) {
+        pool.parallel_for(0, frontier.size(), [&](std::size_t i, unsigned thread) {
+            Vertex u = frontier[i];
+            SignedWeight du = dist[u];
+            G.for_each_arc(u, [&](Vertex w, SignedWeight weight) {
+                SignedWeight candidate;
+                // A walk too long for a SignedWeight: treated as no walk
+                if (__builtin_add_overflow(du, weight, &candidate) or candidate == NEGATIVE_INFINITE_DISTANCE) return;
+                if (candidate < dist[w]) proposals[thread].push_back(Proposal{w, candidate, u});
+            });
+        }, 16);
+        next.clear();
+        for (std::vector<Proposal>& list : proposals) {
+            for (const Proposal& p : list) {
+                if (p.dist >= dist[p.vertex]) continue;
+                dist[p.vertex] = p.dist;
+                prev[p.vertex] = p.from;
+                if (!changed[p.vertex]) {
+                    changed[p.vertex] = 1;
+                    next.push_back(p.vertex);
+                }
+            }
+            list.clear();
+        }
+        for (Vertex w : next) changed[w] = 0;
+        frontier.swap(next);
+        result.rounds++;
+
+        if (result.rounds >= n and !frontier.empty()) {
+            // Every vertex changed from now on is reachable from a negative cycle, and every arc that can still
+            // improve leaves the frontier, so the vertices reachable from this first frontier are exactly the ones
+            // without a shortest path
+            if (affected.empty()) affected = frontier;
+            result.negative_cycle = prev_cycle(prev, dist, root);
+            if (!result.negative_cycle.empty()) break;
+        }
+    }
+    if (affected.empty()) return;
+
+    for (Vertex v : affected) changed[v] = 1;
+    for (std::size_t i = 0; i < affected.size(); i++) {
+        G.for_each_arc(affected[i], [&](Vertex w, SignedWeight) {
+            if (!changed[w]) {
+                changed[w] = 1;
+                affected.push_back(w);
+            }
+        });
+    }
+    for (Vertex v : affected) {
+        dist[v] = NEGATIVE_INFINITE_DISTANCE;
+        prev[v] = NO_VERTEX;
+    }
+}
+
+// Single-source shortest paths with negative arc weights. Runs at most n rounds unless there is a negative
+// cycle reachable from v, which is then reported in negative_cycle; dist is exact everywhere else.
+inline BellmanFordResult bellman_ford(const SignedGraph& G, Vertex v, ThreadPool& pool) {
+    std::size_t n = G.num_vertices();
+    BellmanFordResult result;
+    result.dist.assign(n, SIGNED_INFINITE_DISTANCE);
+    result.prev.assign(n, NO_VERTEX);
+    if (v >= n) { return result; }
+    result.dist[v] = 0;
+    result.prev[v] = v;
+    bellman_ford_rounds(G, result, std::vector<Vertex>(1, v), v, pool);
+    return result;
+}
+
+inline BellmanFordResult bellman_ford(const SignedGraph& G, Vertex v, unsigned threads = 0) {
+    ThreadPool pool(threads);
+    return bellman_ford(G, v, pool);
+}
+
+// Johnson's reweighting: with potentials h from one Bellman-Ford run from a virtual source that has a zero arc
+// to every vertex, w(u, v) + h(u) - h(v) >= 0 on every arc and every u-v path changes by the same h(u) - h(v),
+// so shortest paths stay shortest. The reweighted graph has a for_each_neighbor with Weights and goes straight
+// into dijkstra, integer_dijkstra, distance_matrix and the rest; original_distance converts back. Only valid
+// without a negative cycle: check has_negative_cycle first.
+class JohnsonGraph {
+    private:
+        const SignedGraph& G;
+        std::vector<SignedWeight> potential;
+        std::vector<Vertex> negative_cycle;
+        std::size_t rounds = 0;
+
+        void check() const {
+            if (!negative_cycle.empty()) throw std::runtime_error("Graph has a negative cycle");
+        }
+
+        void reweight(ThreadPool& pool) {
+            std::size_t n = G.num_vertices();
+            BellmanFordResult result;
+            // The virtual source's round is already done: every vertex starts at 0 and in the frontier
+            result.dist.assign(n, 0);
+            result.prev.assign(n, NO_VERTEX);
+            std::vector<Vertex> frontier(n);
+            for (Vertex v = 0; v < n; v++) frontier[v] = v;
+            bellman_ford_rounds(G, result, std::move(frontier), NO_VERTEX, pool);
+            potential = std::move(result.dist);
+            negative_cycle = std::move(result.negative_cycle);
+            rounds = result.rounds;
+        }
+
+    public:
+        JohnsonGraph(const SignedGraph& G, ThreadPool& pool) : G(G) { reweight(pool); }
+
+        JohnsonGraph(const SignedGraph& G, unsigned threads = 0) : G(G) {
+            ThreadPool pool(threads);
+            reweight(pool);
+        }
+
+        bool has_negative_cycle() const { return !negative_cycle.empty(); }
+        const std::vector<Vertex>& get_negative_cycle() const { return negative_cycle; }
+        std::size_t get_rounds() const { return rounds; }
+        SignedWeight get_potential(Vertex v) const { return potential[v]; }
+
+        std::size_t num_vertices() const { return G.num_vertices(); }
+
+        // Calls f(w, weight) for every arc v -> w with its reweighted, non-negative weight
+        template <typename FUNCTION>
+        void for_each_neighbor(Vertex v, FUNCTION&& f) const {
+            SignedWeight hv = potential[v];
+            G.for_each_arc(v, [&](Vertex w, SignedWeight weight) {
+                f(w, static_cast<Weight>(weight + hv - potential[w]));
+            });
+        }
+
+        // The original length of a shortest s-t path from its reweighted length
+        SignedWeight original_distance(Vertex s, Vertex t, Weight reweighted) const {
+            if (reweighted == INFINITE_DISTANCE) return SIGNED_INFINITE_DISTANCE;
+            return static_cast<SignedWeight>(reweighted) - potential[s] + potential[t];
+        }
+
+        // One-to-all distances in the original weights, by integer Dijkstra on the reweighted graph
+        std::vector<SignedWeight> distances_from(Vertex s, QueueBackend backend = QueueBackend::RADIX_HEAP) const {
+            check();
+            std::vector<SignedWeight> dist(num_vertices(), SIGNED_INFINITE_DISTANCE);
+            if (s >= num_vertices()) return dist;
+            auto [reweighted, prev] = integer_dijkstra(*this, s, NO_VERTEX, backend);
+            for (Vertex t = 0; t < dist.size(); t++) dist[t] = original_distance(s, t, reweighted[t]);
+            return dist;
+        }
+
+        // All pairs: out[s * n + t] is the distance from s to t, one Dijkstra per source spread over the pool
+        void all_pairs(SignedWeight* out, ThreadPool& pool) const {
+            check();
+            std::size_t n = num_vertices();
+            std::vector<RadixHeap> queues(pool.size(), RadixHeap(n));
+            pool.parallel_for(0, n, [&](std::size_t s, unsigned thread) {
+                SearchStats stats;
+                auto [reweighted, prev] = integer_dijkstra(*this, s, NO_VERTEX, queues[thread], stats);
+                SignedWeight* row = out + s * n;
+                for (Vertex t = 0; t < n; t++) row[t] = original_distance(s, t, reweighted[t]);
+            }, 1);
+        }
+
+        void all_pairs(SignedWeight* out, unsigned threads = 0) const {
+            ThreadPool pool(threads);
+            all_pairs(out, pool);
+        }
+};
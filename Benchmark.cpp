@@ -0,0 +1,451 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "Graph.hpp"
+#include "CSRGraph.hpp"
+#include "MappedGraph.hpp"
+#include "GraphLoader.hpp"
+#include "GraphGenerators.hpp"
+#include "Landmarks.hpp"
+#include "ContractionHierarchy.hpp"
+#include "CustomizableRoutePlanner.hpp"
+#include "DistanceMatrix.hpp"
+#include "VertexOrder.hpp"
+#include "BellmanFord.hpp"
+#include "MinimumSpanningTree.hpp"
+
+// Usage: benchmark [--graph grid|geometric|erdos-renyi|power-law|<file>] [--vertices N] [--degree D]
+//                  [--seed S] [--queries Q] [--threads T] [--modes a,b,...] [--output FILE]
+//                  [--order none|random|bfs|rcm|hilbert]
+// Builds (or loads) one graph, then times every query mode over the same seeded random queries and writes one
+// JSON object with the build times, per-mode latency percentiles, vertices touched per query and the peak RSS.
+// --order renumbers the vertices before anything is built (hilbert needs coordinates); the queries are drawn in
+// the original ids, so runs with different orders answer the same queries.
+// Build with -DSHORTEST_PATH_STATS to also get settled vertices and edge relaxations per query.
+// Modes: dijkstra, dijkstra_csr, dijkstra_simd, dijkstra_context, integer_heap, radix_heap, dial, bidirectional, astar, alt, ch,
+// crp, delta_stepping, bellman_ford, distance_matrix, kruskal, filter_kruskal, boruvka. integer_heap, radix_heap and dial run integer_dijkstra on the CSR graph;
+// dial only makes sense with small weights (grid, erdos-renyi, power-law), not with geometric lengths.
+// For crp, preprocess_seconds covers partition plus the first customization and customize_seconds one more
+// customization on its own, which is what a weight update costs. bellman_ford runs the parallel relaxation rounds
+// on a signed copy of the graph (both directions of every edge), so it measures the cost of allowing negative weights.
+// kruskal, filter_kruskal and boruvka each time a few minimum spanning forests of the whole graph; vertices
+// touched counts the forest edges.
+// Leave ch and crp out on erdos-renyi and power-law graphs: without a road-like hierarchy CH preprocessing
+// blows up, and without small separators the CRP cells get huge boundary cliques.
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Peak resident set size of the process so far, in kilobytes
+long peak_rss_kb() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+struct Options {
+    std::string graph = "geometric";
+    std::size_t vertices = 100000;
+    double degree = 8;
+    unsigned seed = 1;
+    std::size_t queries = 1000;
+    unsigned threads = 0;
+    std::vector<std::string> modes = {"dijkstra", "dijkstra_csr", "dijkstra_simd", "dijkstra_context", "integer_heap",
+                                      "radix_heap", "dial", "bidirectional", "astar", "alt", "ch",
+                                      "crp", "delta_stepping", "bellman_ford", "distance_matrix",
+                                      "kruskal", "filter_kruskal", "boruvka"};
+    std::string output;
+    std::string order = "none";
+};
+
+struct ModeResult {
+    std::string mode;
+    double preprocess_seconds = 0;
+    double customize_seconds = 0;
+    std::vector<double> latencies;      // microseconds, one per query
+    double touched = 0;                 // total vertices labelled over all queries
+    SearchStats stats;                  // summed over all queries (zero unless built with SHORTEST_PATH_STATS)
+    long peak_rss_kb = 0;
+};
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    std::size_t index = static_cast<std::size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, index > 0 ? index - 1 : 0)];
+}
+
+// Times f(i) for every query index and records the latency of each call
+template <typename FUNCTION>
+void time_queries(ModeResult& result, std::size_t count, FUNCTION&& f) {
+    result.latencies.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        Clock::time_point start = Clock::now();
+        f(i);
+        result.latencies.push_back(seconds_since(start) * 1e6);
+    }
+}
+
+std::size_t count_reached(const std::vector<double>& dist) {
+    std::size_t reached = 0;
+    for (double d : dist) reached += d != 1.0 / 0.0;
+    return reached;
+}
+
+void write_json(std::ostream& out, const Options& options, std::size_t n, std::size_t m,
+                const std::vector<std::pair<std::string, double>>& build, const std::vector<ModeResult>& results) {
+    out << "{\n";
+    out << "  \"graph\": \"" << options.graph << "\",\n";
+    out << "  \"seed\": " << options.seed << ",\n";
+    out << "  \"order\": \"" << options.order << "\",\n";
+    out << "  \"stats_enabled\": " << (STATS_ENABLED ? "true" : "false") << ",\n";
+    out << "  \"vertices\": " << n << ",\n";
+    out << "  \"edges\": " << m << ",\n";
+    out << "  \"build_seconds\": {";
+    for (std::size_t i = 0; i < build.size(); i++) {
+        out << (i ? ", " : "") << "\"" << build[i].first << "\": " << build[i].second;
+    }
+    out << "},\n";
+    out << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const ModeResult& r = results[i];
+        std::vector<double> sorted = r.latencies;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0;
+        for (double l : sorted) total += l;
+        std::size_t count = sorted.size();
+        out << "    {\"mode\": \"" << r.mode << "\", \"queries\": " << count
+            << ", \"preprocess_seconds\": " << r.preprocess_seconds
+            << ", \"customize_seconds\": " << r.customize_seconds
+            << ", \"mean_us\": " << (count ? total / count : 0)
+            << ", \"p50_us\": " << percentile(sorted, 0.5)
+            << ", \"p90_us\": " << percentile(sorted, 0.9)
+            << ", \"p99_us\": " << percentile(sorted, 0.99)
+            << ", \"max_us\": " << (count ? sorted.back() : 0)
+            << ", \"mean_touched\": " << (count ? r.touched / count : 0)
+            << ", \"mean_settled\": " << (count ? double(r.stats.settled) / count : 0)
+            << ", \"mean_relaxations\": " << (count ? double(r.stats.relaxations) / count : 0)
+            << ", \"peak_rss_kb\": " << r.peak_rss_kb << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n";
+    out << "  \"peak_rss_kb\": " << peak_rss_kb() << "\n";
+    out << "}\n";
+}
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i], value = argv[i + 1];
+        if (flag == "--graph") options.graph = value;
+        else if (flag == "--vertices") options.vertices = std::stoul(value);
+        else if (flag == "--degree") options.degree = std::stod(value);
+        else if (flag == "--seed") options.seed = static_cast<unsigned>(std::stoul(value));
+        else if (flag == "--queries") options.queries = std::stoul(value);
+        else if (flag == "--threads") options.threads = static_cast<unsigned>(std::stoul(value));
+        else if (flag == "--output") options.output = value;
+        else if (flag == "--order") options.order = value;
+        else if (flag == "--modes") {
+            options.modes.clear();
+            std::stringstream list(value);
+            for (std::string mode; std::getline(list, mode, ',');) options.modes.push_back(mode);
+        }
+        else {
+            std::cerr << "Unknown option " << flag << std::endl;
+            return false;
+        }
+    }
+    if (argc % 2 == 0) {
+        std::cerr << "Missing value for " << argv[argc - 1] << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) return 1;
+
+    std::vector<std::pair<std::string, double>> build;
+    std::vector<Edge> edges;
+    std::vector<Coordinate> coordinates;
+    bool geographic = false;
+    Clock::time_point start = Clock::now();
+    try {
+        std::size_t n = options.vertices;
+        if (options.graph == "grid") {
+            std::size_t side = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(n))));
+            edges = grid_graph(side, side, 100, options.seed, &coordinates);
+        }
+        else if (options.graph == "geometric") edges = random_geometric_graph(n, options.degree, options.seed, &coordinates);
+        else if (options.graph == "erdos-renyi") edges = erdos_renyi_graph(n, options.degree, 100, options.seed);
+        else if (options.graph == "power-law") edges = power_law_graph(n, static_cast<std::size_t>(options.degree / 2), 100, options.seed);
+        else {
+            // A road network file: packed graph files carry lon/lat coordinates, text files carry none
+            std::ifstream file(options.graph, std::ios::binary);
+            char magic[sizeof(GRAPH_FILE_MAGIC)] = {};
+            file.read(magic, sizeof(magic));
+            if (file and std::memcmp(magic, GRAPH_FILE_MAGIC, sizeof(magic)) == 0) {
+                MappedGraph M(options.graph);
+                for (Vertex v = 0; v < M.num_vertices(); v++) {
+                    M.for_each_neighbor(v, [&](Vertex w, Weight weight) {
+                        if (v < w) edges.push_back(Edge(v, w, weight));
+                    });
+                }
+                if (M.has_coordinates()) {
+                    coordinates.resize(M.num_vertices());
+                    for (Vertex v = 0; v < M.num_vertices(); v++) coordinates[v] = M.get_coordinate(v);
+                    geographic = true;
+                }
+            }
+            else {
+                for (std::vector<Edge>& chunk : load_edge_chunks(options.graph, detect_format(options.graph), nullptr, options.threads)) {
+                    edges.insert(edges.end(), chunk.begin(), chunk.end());
+                }
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    build.push_back({"generate", seconds_since(start)});
+
+    VertexPermutation permutation;
+    if (options.order != "none") {
+        start = Clock::now();
+        CSRGraph original(edges, coordinates.size());
+        std::size_t count = original.num_vertices();
+        if (options.order == "random") permutation = random_order(count, options.seed);
+        else if (options.order == "bfs") permutation = bfs_order(original);
+        else if (options.order == "rcm") permutation = reverse_cuthill_mckee_order(original);
+        else if (options.order == "hilbert" and coordinates.size() == count) permutation = hilbert_order(coordinates);
+        else {
+            std::cerr << "Cannot apply vertex order " << options.order << std::endl;
+            return 1;
+        }
+        edges = permutation.relabel(edges);
+        if (coordinates.size() == count) coordinates = permutation.internal_labels(coordinates);
+        build.push_back({"reorder", seconds_since(start)});
+    }
+
+    start = Clock::now();
+    Graph G(edges);
+    build.push_back({"graph", seconds_since(start)});
+    start = Clock::now();
+    CSRGraph C(edges, G.num_vertices());
+    build.push_back({"csr", seconds_since(start)});
+    std::size_t n = C.num_vertices(), m = edges.size();
+    std::vector<Edge>().swap(edges);
+    std::cerr << options.graph << ": " << n << " vertices, " << m << " edges" << std::endl;
+    if (n == 0) {
+        std::cerr << "Empty graph" << std::endl;
+        return 1;
+    }
+
+    std::mt19937_64 rng(options.seed);
+    std::uniform_int_distribution<Vertex> vertex(0, n - 1);
+    std::vector<std::pair<Vertex, Vertex>> queries(options.queries);
+    for (auto& q : queries) q = {permutation.to_internal(vertex(rng)), permutation.to_internal(vertex(rng))};
+    ThreadPool pool(options.threads);
+
+    std::unique_ptr<ContractionHierarchy> CH;
+    std::vector<ModeResult> results;
+    for (const std::string& mode : options.modes) {
+        ModeResult result;
+        result.mode = mode;
+        std::cerr << "Running " << mode << std::endl;
+        if (mode == "dijkstra") {
+            time_queries(result, queries.size(), [&](std::size_t i) {
+                auto [dist, prev, stats] = G.TracedDijkstra(queries[i].first, queries[i].second);
+                result.touched += count_reached(dist);
+                result.stats += stats;
+            });
+        }
+        else if (mode == "dijkstra_csr") {
+            time_queries(result, queries.size(), [&](std::size_t i) {
+                SearchStats stats;
+                auto [dist, prev] = dijkstra(C, queries[i].first, queries[i].second, stats);
+                result.touched += count_reached(dist);
+                result.stats += stats;
+            });
+        }
+        else if (mode == "dijkstra_simd") {
+            std::cerr << "Relaxing with " << simd_level_name(best_simd_level()) << std::endl;
+            time_queries(result, queries.size(), [&](std::size_t i) {
+                SearchStats stats;
+                auto [dist, prev] = simd_dijkstra(C, queries[i].first, queries[i].second, stats);
+                result.touched += count_reached(dist);
+                result.stats += stats;
+            });
+        }
+        else if (mode == "dijkstra_context") {
+            QueryContext ctx(n);
+            time_queries(result, queries.size(), [&](std::size_t i) {
+                dijkstra(C, queries[i].first, queries[i].second, ctx);
+                result.touched += ctx.num_touched();
+                result.stats += ctx.get_stats();
+            });
+        }
+        else if (mode == "integer_heap" or mode == "radix_heap" or mode == "dial") {
+            auto run = [&](auto& pq) {
+                time_queries(result, queries.size(), [&](std::size_t i) {
+                    SearchStats stats;
+                    auto [dist, prev] = integer_dijkstra(C, queries[i].first, queries[i].second, pq, stats);
+                    for (Weight d : dist) result.touched += d != INFINITE_DISTANCE;
+                    result.stats += stats;
+                });
+            };
+            if (mode == "integer_heap") {
+                IndexedHeap<Weight, 4> pq(n);
+                run(pq);
+            }
+            else if (mode == "radix_heap") {
+                RadixHeap pq(n);
+                run(pq);
+            }
+            else {
+                start = Clock::now();
+                BucketQueue pq(n, max_weight(C));
+                result.preprocess_seconds = seconds_since(start);
+                run(pq);
+            }
+        }
+        else if (mode == "bidirectional") {
+            QueryContext forward(n), backward(n);
+            time_queries(result, queries.size(), [&](std::size_t i) {
+                bidirectional_dijkstra(C, queries[i].first, queries[i].second, forward, backward);
+                result.touched += forward.num_touched() + backward.num_touched();
+                result.stats += forward.get_stats();
+                result.stats += backward.get_stats();
+            });
+        }
+        else if (mode == "astar") {
+            if (coordinates.size() != n) {
+                std::cerr << "Skipping astar: the graph has no coordinates" << std::endl;
+                continue;
+            }
+            auto run = [&](auto heuristic) {
+                time_queries(result, queries.size(), [&](std::size_t i) {
+                    SearchStats stats;
+                    auto [dist, prev] = astar(C, queries[i].first, queries[i].second, heuristic, stats);
+                    result.touched += count_reached(dist);
+                    result.stats += stats;
+                });
+            };
+            start = Clock::now();
+            if (geographic) {
+                double scale = admissible_scale<HaversineHeuristic>(C, coordinates);
+                result.preprocess_seconds = seconds_since(start);
+                run(HaversineHeuristic(coordinates, scale));
+            }
+            else {
+                double scale = admissible_scale<EuclideanHeuristic>(C, coordinates);
+                result.preprocess_seconds = seconds_since(start);
+                run(EuclideanHeuristic(coordinates, scale));
+            }
+        }
+        else if (mode == "alt") {
+            start = Clock::now();
+            Landmarks landmarks(C, 16, LandmarkSelection::AVOID, options.seed);
+            result.preprocess_seconds = seconds_since(start);
+            time_queries(result, queries.size(), [&](std::size_t i) {
+                SearchStats stats;
+                auto [dist, prev] = astar(C, queries[i].first, queries[i].second, LandmarkHeuristic(landmarks), stats);
+                result.touched += count_reached(dist);
+                result.stats += stats;
+            });
+        }
+        else if (mode == "ch") {
+            start = Clock::now();
+            CH.reset(new ContractionHierarchy(C, options.threads));
+            result.preprocess_seconds = seconds_since(start);
+            QueryContext forward(n), backward(n);
+            time_queries(result, queries.size(), [&](std::size_t i) {
+                CH->Query(queries[i].first, queries[i].second, forward, backward);
+                result.touched += forward.num_touched() + backward.num_touched();
+                result.stats += forward.get_stats();
+                result.stats += backward.get_stats();
+            });
+        }
+        else if (mode == "crp") {
+            start = Clock::now();
+            CustomizableRoutePlanner crp(G, {}, options.threads);
+            result.preprocess_seconds = seconds_since(start);
+            start = Clock::now();
+            crp.customize(pool);
+            result.customize_seconds = seconds_since(start);
+            QueryContext forward(n), backward(n);
+            time_queries(result, queries.size(), [&](std::size_t i) {
+                crp.Query(queries[i].first, queries[i].second, forward, backward);
+                result.touched += forward.num_touched() + backward.num_touched();
+                result.stats += forward.get_stats();
+                result.stats += backward.get_stats();
+            });
+        }
+        else if (mode == "delta_stepping") {
+            // One-to-all, so far fewer runs
+            time_queries(result, std::min<std::size_t>(queries.size(), 10), [&](std::size_t i) {
+                auto [dist, prev] = delta_stepping(C, queries[i].first, pool);
+                result.touched += count_reached(dist);
+            });
+        }
+        else if (mode == "bellman_ford") {
+            start = Clock::now();
+            SignedGraph S(G);
+            result.preprocess_seconds = seconds_since(start);
+            time_queries(result, std::min<std::size_t>(queries.size(), 10), [&](std::size_t i) {
+                BellmanFordResult r = bellman_ford(S, queries[i].first, pool);
+                for (SignedWeight d : r.dist) result.touched += d != SIGNED_INFINITE_DISTANCE;
+            });
+        }
+        else if (mode == "kruskal" or mode == "filter_kruskal" or mode == "boruvka") {
+            SpanningForestMethod method = mode == "kruskal" ? SpanningForestMethod::KRUSKAL
+                                        : mode == "filter_kruskal" ? SpanningForestMethod::FILTER_KRUSKAL : SpanningForestMethod::BORUVKA;
+            const std::vector<Edge>& graph_edges = G.get_data();
+            time_queries(result, std::min<std::size_t>(queries.size(), 3), [&](std::size_t) {
+                SpanningForest forest = minimum_spanning_forest(graph_edges, n, pool, method);
+                result.touched += forest.edges.size();
+            });
+        }
+        else if (mode == "distance_matrix") {
+            // One 100 x 100 table per run; uses the hierarchy when the ch mode ran before this one
+            std::size_t side = std::min<std::size_t>(100, queries.size());
+            std::vector<Vertex> sources, targets;
+            for (std::size_t i = 0; i < side; i++) {
+                sources.push_back(queries[i].first);
+                targets.push_back(queries[i].second);
+            }
+            std::vector<double> table(side * side);
+            time_queries(result, 3, [&](std::size_t) {
+                if (CH) distance_matrix(*CH, sources, targets, table.data(), pool);
+                else distance_matrix(C, sources, targets, table.data(), pool);
+            });
+        }
+        else {
+            std::cerr << "Unknown mode " << mode << std::endl;
+            return 1;
+        }
+        result.peak_rss_kb = peak_rss_kb();
+        results.push_back(result);
+    }
+
+    if (options.output.empty()) {
+        write_json(std::cout, options, n, m, build, results);
+    }
+    else {
+        std::ofstream out(options.output);
+        write_json(out, options, n, m, build, results);
+    }
+    return 0;
+}
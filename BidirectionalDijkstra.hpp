@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Dijkstra.hpp"
+
+struct IgnoreNeighbor {
+    void operator()(Vertex, Weight) const {}
+};
+
+// Whether GRAPH is directed, i.e. has a for_each_in_neighbor of its own
+template <typename GRAPH, typename = void>
+struct has_in_neighbors : std::false_type {};
+
+template <typename GRAPH>
+struct has_in_neighbors<GRAPH, std::void_t<decltype(std::declval<const GRAPH&>().for_each_in_neighbor(Vertex(), IgnoreNeighbor()))>>
+    : std::true_type {};
+
+// Calls f(u, weight) for every edge u -> v: the in-neighbors of a directed graph, the plain neighbors of an
+// undirected one, where every edge goes both ways
+template <typename GRAPH, typename FUNCTION>
+void for_each_in_neighbor(const GRAPH& G, Vertex v, FUNCTION&& f) {
+    if constexpr (has_in_neighbors<GRAPH>::value) G.for_each_in_neighbor(v, f);
+    else G.for_each_neighbor(v, f);
+}
+
+// G with every edge turned around, for searches towards a target with any of the one-way engines
+template <typename GRAPH>
+class ReverseGraph {
+    private:
+        const GRAPH& G;
+
+    public:
+        explicit ReverseGraph(const GRAPH& G) : G(G) {}
+
+        std::size_t num_vertices() const { return G.num_vertices(); }
+
+        template <typename FUNCTION>
+        void for_each_neighbor(Vertex v, FUNCTION&& f) const { ::for_each_in_neighbor(G, v, f); }
+
+        template <typename FUNCTION>
+        void for_each_in_neighbor(Vertex v, FUNCTION&& f) const { G.for_each_neighbor(v, f); }
+};
+
+// Point-to-point Dijkstra that grows a forward search from v and a backward search from end, one
+// settled vertex per side in turn. mu tracks the best v-end path seen through any edge joining the two
+// searches, and the query stops once the two queue minima add up to at least mu, since no path through
+// an unsettled vertex can beat it. Returns the distance (infinity if unreachable) and the path v..end.
+// On a directed graph the backward search follows the in-arcs (see for_each_in_neighbor). The two contexts
+// hold the forward and backward labels and counters and are reset first; their ARITY picks the heap.
+template <unsigned ARITY, typename GRAPH>
+std::tuple<double, std::vector<Vertex>> bidirectional_dijkstra(const GRAPH& G, Vertex v, Vertex end, BasicQueryContext<ARITY>& forward,
+                                                               BasicQueryContext<ARITY>& backward) {
+    double inf = 1.0 / 0.0;
+    std::size_t n = G.num_vertices();
+    if (v >= n or end >= n) { return std::tuple(inf, std::vector<Vertex>()); }
+    if (v == end) { return std::tuple(0.0, std::vector<Vertex>(1, v)); }
+
+    BasicQueryContext<ARITY>* ctx[2] = {&forward, &backward};
+    Vertex source[2] = {v, end};
+    for (int side = 0; side < 2; side++) {
+        ctx[side]->resize(n);
+        ctx[side]->reset();
+        ctx[side]->label(source[side], 0, source[side]);
+        ctx[side]->get_heap().push(source[side], 0);
+        stats_count(ctx[side]->get_stats().pushes);
+    }
+
+    double mu = inf;
+    Vertex meet = NO_VERTEX;
+    int side = 0;
+    while (!forward.get_heap().empty() and !backward.get_heap().empty()) {
+        if (forward.get_heap().top_key() + backward.get_heap().top_key() >= mu) break;
+        BasicQueryContext<ARITY>& here = *ctx[side];
+        const BasicQueryContext<ARITY>& other = *ctx[1 - side];
+        SearchStats& stats = here.get_stats();
+        Vertex u = here.get_heap().pop();
+        stats_count(stats.pops);
+        stats_count(stats.settled);
+        double du = here.get_dist(u);
+        auto relax = [&](Vertex w, Weight weight) {
+            stats_count(stats.relaxations);
+            double candidate = du + weight;
+            if (candidate < here.get_dist(w)) {
+                here.label(w, candidate, u);
+                stats_count_push(stats, here.get_heap(), w);
+                here.get_heap().push_or_decrease(w, candidate);
+            }
+            if (candidate + other.get_dist(w) < mu) {
+                mu = candidate + other.get_dist(w);
+                meet = w;
+            }
+        };
+        if (side == 0) G.for_each_neighbor(u, relax);
+        else for_each_in_neighbor(G, u, relax);
+        side = 1 - side;
+    }
+
+    std::vector<Vertex> path;
+    if (meet == NO_VERTEX) { return std::tuple(inf, path); }
+    path = forward.path_to(meet);
+    for (Vertex at = meet; at != end; ) {
+        at = backward.get_prev(at);
+        path.push_back(at);
+    }
+    return std::tuple(mu, path);
+}
+
+template <unsigned ARITY = 4, typename GRAPH>
+std::tuple<double, std::vector<Vertex>> bidirectional_dijkstra(const GRAPH& G, Vertex v, Vertex end) {
+    BasicQueryContext<ARITY> forward(G.num_vertices()), backward(G.num_vertices());
+    return bidirectional_dijkstra(G, v, end, forward, backward);
+}
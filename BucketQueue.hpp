@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using Vertex = unsigned long;
+
+// Dial's bucket queue for integer keys: one bucket per key value, kept in a ring of max_weight + 1 buckets.
+// In Dijkstra every queued key lies within max_weight of the key being settled, so the ring never wraps onto
+// itself; a pop walks forward from the last popped key to the next non-empty bucket and push, pop and
+// decrease-key are O(1) list operations besides that walk. Buckets are intrusive doubly linked lists through
+// per-vertex arrays, so nothing is allocated during a search. Only worth it for small integer weights: the
+// ring costs a pointer per possible weight and the walk crosses every empty key in between.
+class BucketQueue {
+    private:
+        static constexpr Vertex NONE = static_cast<Vertex>(-1);
+
+        std::vector<Vertex> head;  // per bucket
+        std::vector<Vertex> next;  // per vertex
+        std::vector<Vertex> prev;  // per vertex
+        std::vector<std::uint64_t> keys;
+        std::vector<char> queued;
+        std::uint64_t cursor = 0;  // the last popped key; every queued key is in [cursor, cursor + span)
+        std::size_t count = 0;
+
+        std::size_t bucket_of(std::uint64_t key) const { return key % head.size(); }
+
+        void link(Vertex v, std::uint64_t key) {
+            std::size_t b = bucket_of(key);
+            keys[v] = key;
+            prev[v] = NONE;
+            next[v] = head[b];
+            if (head[b] != NONE) prev[head[b]] = v;
+            head[b] = v;
+        }
+
+        void unlink(Vertex v) {
+            if (prev[v] != NONE) next[prev[v]] = next[v];
+            else head[bucket_of(keys[v])] = next[v];
+            if (next[v] != NONE) prev[next[v]] = prev[v];
+        }
+
+        void check(std::uint64_t key) const {
+            if (key < cursor or key - cursor >= head.size()) {
+                throw std::runtime_error("Bucket queue key is outside the window of the last popped key");
+            }
+        }
+
+    public:
+        BucketQueue() : head(1, NONE) {}
+        BucketQueue(std::size_t num_vertices, std::uint64_t max_weight)
+            : head(max_weight + 1, NONE), next(num_vertices), prev(num_vertices), keys(num_vertices), queued(num_vertices, 0) {}
+
+        void resize(std::size_t num_vertices) {
+            if (num_vertices <= queued.size()) return;
+            next.resize(num_vertices);
+            prev.resize(num_vertices);
+            keys.resize(num_vertices);
+            queued.resize(num_vertices, 0);
+        }
+
+        bool empty() const { return count == 0; }
+        std::size_t size() const { return count; }
+        bool contains(Vertex v) const { return v < queued.size() and queued[v]; }
+
+        std::uint64_t get_key(Vertex v) const { return keys[v]; }
+
+        void push(Vertex v, std::uint64_t key) {
+            if (contains(v)) { throw std::runtime_error("Vertex is already in the heap"); }
+            check(key);
+            link(v, key);
+            queued[v] = 1;
+            count++;
+        }
+
+        void decrease_key(Vertex v, std::uint64_t key) {
+            check(key);
+            unlink(v);
+            link(v, key);
+        }
+
+        bool push_or_decrease(Vertex v, std::uint64_t key) {
+            if (!contains(v)) {
+                push(v, key);
+                return true;
+            }
+            if (!(key < get_key(v))) return false;
+            decrease_key(v, key);
+            return true;
+        }
+
+        Vertex pop() {
+            if (count == 0) { throw std::runtime_error("Cannot pop from an empty heap"); }
+            std::size_t b = bucket_of(cursor);
+            while (head[b] == NONE) {
+                cursor++;
+                b = b + 1 == head.size() ? 0 : b + 1;
+            }
+            Vertex v = head[b];
+            unlink(v);
+            queued[v] = 0;
+            count--;
+            return v;
+        }
+
+        // Walks the ring once; the next search may start again from key 0
+        void clear() {
+            for (Vertex& first : head) {
+                for (Vertex v = first; v != NONE; v = next[v]) queued[v] = 0;
+                first = NONE;
+            }
+            cursor = 0;
+            count = 0;
+        }
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include "Graph.hpp"
+#include "SimdRelaxation.hpp"
+
+// The neighbors of one vertex in a packed layout: targets[i] and weights[i] for i < count
+struct PackedRow {
+    const std::uint32_t* targets;
+    const std::uint32_t* weights;
+    std::size_t count;
+};
+
+// A frozen compressed sparse row copy of an undirected Graph. The neighbors of v sit in slots
+// offsets[v] .. offsets[v+1]-1 of the packed targets and weights arrays, which are kept as separate
+// 32-bit arrays (structure of arrays) so a neighbor scan is a linear read of 8 bytes per edge slot.
+class CSRGraph {
+    private:
+        std::vector<std::uint64_t> offsets;
+        std::vector<std::uint32_t> targets;
+        std::vector<std::uint32_t> weights;
+
+        static std::uint32_t narrow(unsigned long x, const char* what) {
+            if (x > std::numeric_limits<std::uint32_t>::max()) {
+                throw std::runtime_error(std::string(what) + " does not fit in 32 bits: " + std::to_string(x));
+            }
+            return static_cast<std::uint32_t>(x);
+        }
+
+        // Builds the rows with one counting sort: count degrees, prefix-sum into offsets, then scatter each edge
+        // into both endpoints' rows. each_edge(f) must call f(edge) for every edge, the same way on every call.
+        template <typename EACH_EDGE>
+        void build(EACH_EDGE&& each_edge, std::size_t num_vertices) {
+            each_edge([&](const Edge& e) {
+                if (e.get_left() >= num_vertices) num_vertices = e.get_left() + 1;
+            });
+            narrow(num_vertices, "Vertex count");
+            offsets.assign(num_vertices + 1, 0);
+            each_edge([&](const Edge& e) {
+                offsets[e.get_left() + 1]++;
+                offsets[e.get_right() + 1]++;
+            });
+            for (std::size_t i = 0; i < num_vertices; i++) {
+                offsets[i + 1] += offsets[i];
+            }
+            targets.resize(offsets[num_vertices]);
+            weights.resize(offsets[num_vertices]);
+            std::vector<std::uint64_t> cursor(offsets.begin(), offsets.end() - 1);
+            each_edge([&](const Edge& e) {
+                std::uint32_t w = narrow(e.get_weight(), "Edge weight");
+                std::uint64_t slot = cursor[e.get_left()]++;
+                targets[slot] = static_cast<std::uint32_t>(e.get_right());
+                weights[slot] = w;
+                slot = cursor[e.get_right()]++;
+                targets[slot] = static_cast<std::uint32_t>(e.get_left());
+                weights[slot] = w;
+            });
+        }
+
+    public:
+        CSRGraph() : offsets(1, 0) {}
+
+        // num_vertices may be larger than the highest id to keep trailing isolated vertices
+        CSRGraph(const std::vector<Edge>& edges, std::size_t num_vertices = 0) {
+            build([&](auto&& f) {
+                for (const Edge& e : edges) f(e);
+            }, num_vertices);
+        }
+
+        // Builds straight from several edge batches (e.g. one per loader thread) without concatenating them first
+        CSRGraph(const std::vector<std::vector<Edge>>& edge_chunks, std::size_t num_vertices = 0) {
+            build([&](auto&& f) {
+                for (const std::vector<Edge>& chunk : edge_chunks) {
+                    for (const Edge& e : chunk) f(e);
+                }
+            }, num_vertices);
+        }
+
+        CSRGraph(Graph& G) : CSRGraph(G.get_data(), G.num_vertices()) {}
+
+        // Adopts already packed arrays, e.g. from a loader that built them itself
+        CSRGraph(std::vector<std::uint64_t> offsets, std::vector<std::uint32_t> targets, std::vector<std::uint32_t> weights)
+            : offsets(std::move(offsets)), targets(std::move(targets)), weights(std::move(weights)) {
+            if (this->offsets.empty() or this->offsets.back() != this->targets.size() or this->targets.size() != this->weights.size()) {
+                throw std::runtime_error("Inconsistent CSR arrays");
+            }
+        }
+
+        std::size_t num_vertices() const { return offsets.size() - 1; }
+        // Every undirected edge occupies two slots, one in each endpoint's row
+        std::size_t num_slots() const { return targets.size(); }
+        std::size_t degree(Vertex v) const { return offsets[v + 1] - offsets[v]; }
+
+        template <typename FUNCTION>
+        void for_each_neighbor(Vertex v, FUNCTION&& f) const {
+            std::uint64_t end = offsets[v + 1];
+            for (std::uint64_t i = offsets[v]; i < end; i++) {
+                f(static_cast<Vertex>(targets[i]), static_cast<Weight>(weights[i]));
+            }
+        }
+
+        PackedRow row(Vertex v) const { return PackedRow{targets.data() + offsets[v], weights.data() + offsets[v], degree(v)}; }
+
+        const std::vector<std::uint64_t>& get_offsets() const { return offsets; }
+        const std::vector<std::uint32_t>& get_targets() const { return targets; }
+        const std::vector<std::uint32_t>& get_weights() const { return weights; }
+
+        std::size_t memory_bytes() const {
+            return offsets.size() * sizeof(std::uint64_t) + targets.size() * sizeof(std::uint32_t) + weights.size() * sizeof(std::uint32_t);
+        }
+
+        template <unsigned ARITY = 4>
+        std::tuple<std::vector<double>, std::vector<Vertex>> Dijkstra(Vertex v, Vertex end) const {
+            return dijkstra<ARITY>(*this, v, end);
+        }
+
+        // Dijkstra relaxing whole rows with the AVX2/AVX-512 kernels (see SimdRelaxation.hpp)
+        std::tuple<std::vector<double>, std::vector<Vertex>> SimdDijkstra(Vertex v, Vertex end = NO_VERTEX) const {
+            return simd_dijkstra(*this, v, end);
+        }
+};
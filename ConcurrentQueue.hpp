@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+// Bounded lock-free multi-producer multi-consumer queue (Vyukov's ring of sequenced cells). Every cell
+// carries a sequence number that tells producers and consumers whose turn it is, so a push or pop is one
+// CAS on the shared position plus one release store, and threads never wait on each other's locks.
+// try_push fails when the ring is full and try_pop when it is empty; callers decide whether to spin or back off.
+template <typename T>
+class ConcurrentQueue {
+    private:
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        // Producers and consumers hammer different positions, so keep them on separate cache lines
+        alignas(64) std::atomic<std::size_t> enqueue_pos;
+        alignas(64) std::atomic<std::size_t> dequeue_pos;
+        alignas(64) std::unique_ptr<Cell[]> cells;
+        std::size_t mask;
+
+    public:
+        // capacity is rounded up to a power of two
+        ConcurrentQueue(std::size_t capacity = 1024) : enqueue_pos(0), dequeue_pos(0) {
+            if (capacity < 2) capacity = 2;
+            std::size_t size = 1;
+            while (size < capacity) size <<= 1;
+            if (size == 0) throw std::length_error("ConcurrentQueue capacity is too large");
+            cells.reset(new Cell[size]);
+            for (std::size_t i = 0; i < size; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+            mask = size - 1;
+        }
+
+        ConcurrentQueue(const ConcurrentQueue&) = delete;
+        ConcurrentQueue& operator=(const ConcurrentQueue&) = delete;
+
+        std::size_t capacity() const { return mask + 1; }
+
+        bool try_push(const T& value) {
+            std::size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+            while (true) {
+                Cell& cell = cells[pos & mask];
+                std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.value = value;
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    // The cell still holds an element from one lap ago: full
+                    return false;
+                }
+                else {
+                    pos = enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_pop(T& value) {
+            std::size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+            while (true) {
+                Cell& cell = cells[pos & mask];
+                std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        value = cell.value;
+                        cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    // Nothing has been written to this cell on the current lap: empty
+                    return false;
+                }
+                else {
+                    pos = dequeue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+};
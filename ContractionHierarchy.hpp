@@ -0,0 +1,415 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "Graph.hpp"
+#include "ThreadPool.hpp"
+
+// An Edge created by contracting 'middle': it stands for the path left - middle - right. Original edges
+// have no middle vertex.
+class Shortcut : public Edge {
+    private:
+        Vertex middle;
+    public:
+        Shortcut() : middle(NO_VERTEX) {}
+        Shortcut(Vertex v1, Vertex v2, Weight w, Vertex middle = NO_VERTEX) : Edge(v1, v2, w), middle(middle) {}
+
+        Vertex get_middle() const { return middle; }
+        bool is_shortcut() const { return middle != NO_VERTEX; }
+};
+
+// Contraction Hierarchies for undirected graphs. Preprocessing removes ("contracts") vertices one at a time
+// in order of importance, adding a Shortcut between two neighbors whenever the path through the removed
+// vertex is the only shortest one (checked with a bounded witness search). Every edge then points from a
+// lower to a higher ranked vertex, and a shortest path always climbs and then descends the ranks, so a
+// query only runs two small upward searches.
+//
+// Preprocessing contracts in rounds: each round takes every remaining vertex whose priority (edge
+// difference + contracted neighbors) is a strict local minimum among its neighbors. Those vertices are
+// pairwise non-adjacent, so their witness searches run in parallel, each ignoring all vertices of the round.
+class ContractionHierarchy {
+    private:
+        struct Arc {
+            Vertex to;
+            Weight weight;
+            Vertex middle;
+        };
+
+        // Bounded Dijkstra on the not yet contracted graph, one per thread
+        struct WitnessSearch {
+            std::vector<Weight> dist;
+            std::vector<char> is_target;
+            std::vector<Vertex> touched;
+            IndexedHeap<Weight, 4> heap;
+            SearchStats stats;
+
+            WitnessSearch(std::size_t n) : dist(n, INFINITE), is_target(n, 0), heap(n) {}
+
+            void reset() {
+                for (Vertex v : touched) dist[v] = INFINITE;
+                touched.clear();
+                heap.clear();
+            }
+        };
+
+        static constexpr Weight INFINITE = std::numeric_limits<Weight>::max();
+        static constexpr std::size_t WITNESS_SETTLE_LIMIT = 500;
+        static constexpr char MAGIC[8] = {'S', 'P', 'C', 'H', 'I', 'E', 'R', '\0'};
+        static constexpr std::uint32_t VERSION = 1;
+
+    public:
+        // Where preprocessing spent its time (filled in when built with SHORTEST_PATH_STATS)
+        struct BuildStats {
+            std::uint64_t rounds = 0;
+            std::uint64_t shortcuts = 0;
+            SearchStats witness;  // summed over every witness search
+            double priority_seconds = 0;
+            double contraction_seconds = 0;
+            double packing_seconds = 0;
+        };
+
+    private:
+        BuildStats build_stats;
+
+        // The search graph: for every vertex, its edges to higher ranked vertices
+        std::vector<std::uint32_t> rank;
+        std::vector<std::uint64_t> up_offsets;
+        std::vector<Vertex> up_targets;
+        std::vector<Weight> up_weights;
+        std::vector<Vertex> up_middles;
+
+        // Shortcuts needed to contract x, found with witness searches that skip every vertex with skip[v] set
+        static void find_shortcuts(const std::vector<std::vector<Arc>>& arcs, const std::vector<char>& skip, Vertex x,
+                                   WitnessSearch& search, std::vector<Shortcut>& out) {
+            const std::vector<Arc>& around = arcs[x];
+            for (std::size_t i = 0; i + 1 < around.size(); i++) {
+                // Only paths to the neighbors after u matter, and only while they are shorter than going through x
+                Vertex u = around[i].to;
+                Weight longest = 0;
+                std::size_t targets_left = 0;
+                for (std::size_t j = i + 1; j < around.size(); j++) {
+                    longest = std::max(longest, around[j].weight);
+                    search.is_target[around[j].to] = 1;
+                    targets_left++;
+                }
+                Weight limit = around[i].weight + longest;
+                search.dist[u] = 0;
+                search.touched.push_back(u);
+                search.heap.push(u, 0);
+                stats_count(search.stats.pushes);
+                std::size_t settled = 0;
+                while (!search.heap.empty() and search.heap.top_key() <= limit and settled < WITNESS_SETTLE_LIMIT) {
+                    Vertex y = search.heap.pop();
+                    stats_count(search.stats.pops);
+                    stats_count(search.stats.settled);
+                    settled++;
+                    if (search.is_target[y] and --targets_left == 0) break;
+                    for (const Arc& a : arcs[y]) {
+                        if (a.to == x or skip[a.to]) continue;
+                        stats_count(search.stats.relaxations);
+                        Weight candidate = search.dist[y] + a.weight;
+                        if (candidate < search.dist[a.to]) {
+                            if (search.dist[a.to] == INFINITE) search.touched.push_back(a.to);
+                            search.dist[a.to] = candidate;
+                            stats_count_push(search.stats, search.heap, a.to);
+                            search.heap.push_or_decrease(a.to, candidate);
+                        }
+                    }
+                }
+                for (std::size_t j = i + 1; j < around.size(); j++) {
+                    search.is_target[around[j].to] = 0;
+                    Weight via = around[i].weight + around[j].weight;
+                    if (search.dist[around[j].to] > via) out.push_back(Shortcut(u, around[j].to, via, x));
+                }
+                search.reset();
+            }
+        }
+
+        static void add_arc(std::vector<Arc>& list, Vertex to, Weight weight, Vertex middle) {
+            for (Arc& a : list) {
+                if (a.to == to) {
+                    if (weight < a.weight) a = Arc{to, weight, middle};
+                    return;
+                }
+            }
+            list.push_back(Arc{to, weight, middle});
+        }
+
+        static void remove_arc(std::vector<Arc>& list, Vertex to) {
+            for (std::size_t i = 0; i < list.size(); i++) {
+                if (list[i].to == to) {
+                    list[i] = list.back();
+                    list.pop_back();
+                    return;
+                }
+            }
+        }
+
+        // The middle vertex of the up edge between a and b, whichever of the two ranks lower
+        Vertex middle_of(Vertex a, Vertex b) const {
+            if (rank[a] > rank[b]) std::swap(a, b);
+            for (std::uint64_t i = up_offsets[a]; i < up_offsets[a + 1]; i++) {
+                if (up_targets[i] == b) return up_middles[i];
+            }
+            throw std::runtime_error("Broken shortcut between " + std::to_string(a) + " and " + std::to_string(b));
+        }
+
+        // Appends the original vertices strictly after a up to and including b
+        void unpack(Vertex a, Vertex b, Vertex middle, std::vector<Vertex>& path) const {
+            if (middle == NO_VERTEX) {
+                path.push_back(b);
+                return;
+            }
+            unpack(a, middle, middle_of(a, middle), path);
+            unpack(middle, b, middle_of(middle, b), path);
+        }
+
+    public:
+        ContractionHierarchy() {}
+
+        template <typename GRAPH>
+        ContractionHierarchy(const GRAPH& G, unsigned threads = 0) {
+            static_assert(!has_in_neighbors<GRAPH>::value, "ContractionHierarchy needs an undirected graph");
+            std::size_t n = G.num_vertices();
+            std::vector<std::vector<Arc>> arcs(n);
+            for (Vertex u = 0; u < n; u++) {
+                G.for_each_neighbor(u, [&](Vertex w, Weight weight) {
+                    if (w != u) add_arc(arcs[u], w, weight, NO_VERTEX);
+                });
+            }
+
+            ThreadPool pool(threads);
+            std::vector<WitnessSearch> searches(pool.size(), WitnessSearch(n));
+            std::vector<std::vector<Shortcut>> scratch(pool.size());
+            std::vector<char> skip(n, 0);  // contracted, or being contracted this round
+            std::vector<long> priority(n, 0);
+            std::vector<long> contracted_neighbors(n, 0);
+            auto update_priority = [&](Vertex x, unsigned thread) {
+                scratch[thread].clear();
+                find_shortcuts(arcs, skip, x, searches[thread], scratch[thread]);
+                priority[x] = long(scratch[thread].size()) - long(arcs[x].size()) + contracted_neighbors[x];
+            };
+            {
+                ScopedTimer timer(build_stats.priority_seconds);
+                pool.parallel_for(0, n, update_priority);
+            }
+
+            rank.assign(n, 0);
+            std::vector<std::vector<Arc>> upward(n);
+            std::vector<Vertex> remaining(n);
+            for (Vertex v = 0; v < n; v++) remaining[v] = v;
+            std::uint32_t next_rank = 0;
+            {
+                ScopedTimer timer(build_stats.contraction_seconds);
+                while (!remaining.empty()) {
+                    std::vector<Vertex> round;
+                    for (Vertex x : remaining) {
+                        bool minimum = true;
+                        for (const Arc& a : arcs[x]) {
+                            if (priority[a.to] < priority[x] or (priority[a.to] == priority[x] and a.to < x)) {
+                                minimum = false;
+                                break;
+                            }
+                        }
+                        if (minimum) round.push_back(x);
+                    }
+                    for (Vertex x : round) skip[x] = 1;
+                    stats_count(build_stats.rounds);
+
+                    std::vector<std::vector<Shortcut>> shortcuts(round.size());
+                    pool.parallel_for(0, round.size(), [&](std::size_t i, unsigned thread) {
+                        find_shortcuts(arcs, skip, round[i], searches[thread], shortcuts[i]);
+                    }, 1);
+
+                    std::vector<Vertex> touched;
+                    for (std::size_t i = 0; i < round.size(); i++) {
+                        Vertex x = round[i];
+                        rank[x] = next_rank++;
+                        upward[x] = std::move(arcs[x]);
+                        arcs[x].clear();
+                        for (const Arc& a : upward[x]) {
+                            remove_arc(arcs[a.to], x);
+                            contracted_neighbors[a.to]++;
+                            touched.push_back(a.to);
+                        }
+                        stats_count(build_stats.shortcuts, shortcuts[i].size());
+                        for (const Shortcut& s : shortcuts[i]) {
+                            add_arc(arcs[s.get_left()], s.get_right(), s.get_weight(), x);
+                            add_arc(arcs[s.get_right()], s.get_left(), s.get_weight(), x);
+                        }
+                    }
+                    std::sort(touched.begin(), touched.end());
+                    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+                    pool.parallel_for(0, touched.size(), [&](std::size_t i, unsigned thread) {
+                        update_priority(touched[i], thread);
+                    }, 1);
+
+                    std::size_t kept = 0;
+                    for (Vertex x : remaining) {
+                        if (!skip[x]) remaining[kept++] = x;
+                    }
+                    remaining.resize(kept);
+                }
+            }
+
+            for (const WitnessSearch& search : searches) build_stats.witness += search.stats;
+
+            ScopedTimer timer(build_stats.packing_seconds);
+            up_offsets.assign(n + 1, 0);
+            for (Vertex x = 0; x < n; x++) up_offsets[x + 1] = up_offsets[x] + upward[x].size();
+            for (Vertex x = 0; x < n; x++) {
+                for (const Arc& a : upward[x]) {
+                    up_targets.push_back(a.to);
+                    up_weights.push_back(a.weight);
+                    up_middles.push_back(a.middle);
+                }
+            }
+        }
+
+        std::size_t num_vertices() const { return rank.size(); }
+        const BuildStats& get_build_stats() const { return build_stats; }
+        std::size_t num_up_edges() const { return up_targets.size(); }
+        std::uint32_t get_rank(Vertex v) const { return rank[v]; }
+
+        // Calls f(w, weight, middle) for every edge from v to a higher ranked vertex w
+        template <typename FUNCTION>
+        void for_each_up(Vertex v, FUNCTION&& f) const {
+            for (std::uint64_t i = up_offsets[v]; i < up_offsets[v + 1]; i++) {
+                f(up_targets[i], up_weights[i], up_middles[i]);
+            }
+        }
+
+        // Bidirectional upward search with stall-on-demand; returns the same distance as Dijkstra and the
+        // unpacked path from v to end (empty and infinite if unreachable). The contexts are reset first and can
+        // be reused across queries, so a query only touches its two small search spaces.
+        template <unsigned ARITY>
+        std::tuple<double, std::vector<Vertex>> Query(Vertex v, Vertex end, BasicQueryContext<ARITY>& forward, BasicQueryContext<ARITY>& backward) const {
+            double inf = 1.0 / 0.0;
+            std::size_t n = num_vertices();
+            if (v >= n or end >= n) { return std::tuple(inf, std::vector<Vertex>()); }
+            if (v == end) { return std::tuple(0.0, std::vector<Vertex>(1, v)); }
+
+            BasicQueryContext<ARITY>* ctx[2] = {&forward, &backward};
+            Vertex source[2] = {v, end};
+            for (int side = 0; side < 2; side++) {
+                ctx[side]->resize(n);
+                ctx[side]->reset();
+                ctx[side]->label(source[side], 0, source[side]);
+                ctx[side]->get_heap().push(source[side], 0);
+                stats_count(ctx[side]->get_stats().pushes);
+            }
+
+            double mu = inf;
+            Vertex meet = NO_VERTEX;
+            int side = 0;
+            while (!forward.get_heap().empty() or !backward.get_heap().empty()) {
+                IndexedHeap<double, ARITY>& pq = ctx[side]->get_heap();
+                IndexedHeap<double, ARITY>& other_pq = ctx[1 - side]->get_heap();
+                if (pq.empty() or pq.top_key() >= mu) {
+                    // This side cannot improve mu any more; finish once the other side cannot either
+                    if (other_pq.empty() or other_pq.top_key() >= mu) break;
+                    side = 1 - side;
+                    continue;
+                }
+                BasicQueryContext<ARITY>& here = *ctx[side];
+                SearchStats& stats = here.get_stats();
+                Vertex u = pq.pop();
+                stats_count(stats.pops);
+                double du = here.get_dist(u);
+                if (du + ctx[1 - side]->get_dist(u) < mu) {
+                    mu = du + ctx[1 - side]->get_dist(u);
+                    meet = u;
+                }
+                // Stall: if a higher neighbor already reaches u more cheaply, u is not on a shortest up path
+                bool stalled = false;
+                for_each_up(u, [&](Vertex w, Weight weight, Vertex) {
+                    if (here.get_dist(w) + weight < du) stalled = true;
+                });
+                if (stalled) {
+                    stats_count(stats.stale);
+                }
+                else {
+                    stats_count(stats.settled);
+                    for_each_up(u, [&](Vertex w, Weight weight, Vertex) {
+                        stats_count(stats.relaxations);
+                        double candidate = du + weight;
+                        if (candidate < here.get_dist(w)) {
+                            here.label(w, candidate, u);
+                            stats_count_push(stats, pq, w);
+                            pq.push_or_decrease(w, candidate);
+                        }
+                    });
+                }
+                side = 1 - side;
+            }
+
+            std::vector<Vertex> path;
+            if (meet == NO_VERTEX) { return std::tuple(inf, path); }
+            std::vector<Vertex> climb = forward.path_to(meet);
+            path.push_back(v);
+            for (std::size_t i = 0; i + 1 < climb.size(); i++) {
+                unpack(climb[i], climb[i + 1], middle_of(climb[i], climb[i + 1]), path);
+            }
+            for (Vertex at = meet; at != end; at = backward.get_prev(at)) {
+                unpack(at, backward.get_prev(at), middle_of(at, backward.get_prev(at)), path);
+            }
+            return std::tuple(mu, path);
+        }
+
+        template <unsigned ARITY = 4>
+        std::tuple<double, std::vector<Vertex>> Query(Vertex v, Vertex end) const {
+            BasicQueryContext<ARITY> forward(num_vertices()), backward(num_vertices());
+            return Query(v, end, forward, backward);
+        }
+
+        void save(const std::string& path) const {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            if (!out) { throw std::runtime_error("Cannot open " + path + " for writing"); }
+            std::uint64_t header[2] = {rank.size(), up_targets.size()};
+            out.write(MAGIC, sizeof(MAGIC));
+            out.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+            out.write(reinterpret_cast<const char*>(header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(rank.data()), rank.size() * sizeof(std::uint32_t));
+            out.write(reinterpret_cast<const char*>(up_offsets.data()), up_offsets.size() * sizeof(std::uint64_t));
+            for (std::size_t i = 0; i < up_targets.size(); i++) {
+                std::uint64_t record[3] = {up_targets[i], up_weights[i], up_middles[i]};
+                out.write(reinterpret_cast<const char*>(record), sizeof(record));
+            }
+            if (!out) { throw std::runtime_error("Failed writing " + path); }
+        }
+
+        static ContractionHierarchy load(const std::string& path) {
+            std::ifstream in(path, std::ios::binary);
+            if (!in) { throw std::runtime_error("Cannot open " + path); }
+            char magic[8];
+            std::uint32_t version = 0;
+            std::uint64_t header[2];
+            in.read(magic, sizeof(magic));
+            in.read(reinterpret_cast<char*>(&version), sizeof(version));
+            in.read(reinterpret_cast<char*>(header), sizeof(header));
+            if (!in or std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 or version != VERSION) {
+                throw std::runtime_error(path + " is not a contraction hierarchy file");
+            }
+            ContractionHierarchy CH;
+            CH.rank.resize(header[0]);
+            CH.up_offsets.resize(header[0] + 1);
+            in.read(reinterpret_cast<char*>(CH.rank.data()), CH.rank.size() * sizeof(std::uint32_t));
+            in.read(reinterpret_cast<char*>(CH.up_offsets.data()), CH.up_offsets.size() * sizeof(std::uint64_t));
+            for (std::uint64_t i = 0; i < header[1]; i++) {
+                std::uint64_t record[3];
+                in.read(reinterpret_cast<char*>(record), sizeof(record));
+                CH.up_targets.push_back(record[0]);
+                CH.up_weights.push_back(record[1]);
+                CH.up_middles.push_back(record[2]);
+            }
+            if (!in) { throw std::runtime_error(path + " is truncated"); }
+            return CH;
+        }
+};
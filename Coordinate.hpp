@@ -0,0 +1,7 @@
+#pragma once
+
+// A planar position for a vertex. For geographic graphs x is the longitude and y the latitude, in degrees.
+struct Coordinate {
+    double x;
+    double y;
+};
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+#include "Graph.hpp"
+#include "QueryContext.hpp"
+#include "SearchStats.hpp"
+#include "ThreadPool.hpp"
+
+// Customizable Route Planning (Delling, Goldberg, Pajor & Werneck) for undirected graphs. Preprocessing is
+// split in two:
+//   - the partition depends only on the topology: the vertices are cut into nested cells, level 0 holding the
+//     smallest ones and every cell lying inside one cell of the next level. It is computed once.
+//   - customization depends only on the weights: every cell gets a clique over its boundary vertices (those
+//     with an edge leaving the cell) holding their shortest distances inside the cell. Level 0 is found with
+//     Dijkstra inside the cell, every higher level on the cliques of the level below, all cells of a level in
+//     parallel. Call customize() again after changing weights with Graph::set_weight.
+// A query searches the original edges only in the level-0 cells of its two endpoints and, further away,
+// crosses each cell along its clique on the highest level that contains neither endpoint.
+//
+// Partition cells come from recursive bisection along a breadth-first order, which needs no coordinates and
+// keeps each half connected where possible. Adding or removing edges changes the topology and needs a new
+// planner. The graph must outlive the planner and must not change during a query or customize().
+template <typename GRAPH>
+class CustomizableRoutePlanner {
+    static_assert(!has_in_neighbors<GRAPH>::value, "CustomizableRoutePlanner needs an undirected graph");
+
+    private:
+        static constexpr std::uint32_t NOT_BOUNDARY = static_cast<std::uint32_t>(-1);
+
+        // One level of the partition. The clique of cell c is a row-major matrix over the boundary vertices of
+        // c, in the order they appear in 'boundary'.
+        struct Level {
+            std::vector<std::uint32_t> cell;              // per vertex
+            std::vector<std::uint32_t> boundary_index;    // per vertex: position among the boundary vertices of its cell
+            std::vector<std::uint64_t> boundary_offsets;  // per cell, into boundary
+            std::vector<Vertex> boundary;
+            std::vector<std::uint64_t> clique_offsets;    // per cell, into clique
+            std::vector<double> clique;
+
+            std::size_t num_cells() const { return boundary_offsets.size() - 1; }
+        };
+
+        const GRAPH& G;
+        std::vector<Level> levels;
+
+        // Appends the vertices reachable from 'start' through vertices marked 'inside' to order, breadth-first,
+        // and marks them 'seen'
+        void sweep(Vertex start, std::uint32_t inside, std::uint32_t seen, std::vector<std::uint32_t>& mark, std::vector<Vertex>& order) const {
+            mark[start] = seen;
+            order.push_back(start);
+            for (std::size_t i = order.size() - 1; i < order.size(); i++) {
+                G.for_each_neighbor(order[i], [&](Vertex w, Weight) {
+                    if (mark[w] == inside) {
+                        mark[w] = seen;
+                        order.push_back(w);
+                    }
+                });
+            }
+        }
+
+        // Cuts piece in halves until every part has at most 'limit' vertices. Each cut orders the piece
+        // breadth-first from a far-away vertex (the last one reached from an arbitrary start), so the first half
+        // is a ball around that vertex.
+        void bisect(std::vector<Vertex>& piece, std::size_t limit, std::vector<std::uint32_t>& mark, std::uint32_t& stamp,
+                    std::vector<std::vector<Vertex>>& parts) const {
+            if (piece.size() <= limit) {
+                parts.push_back(std::move(piece));
+                return;
+            }
+            std::uint32_t inside = ++stamp, seen = ++stamp;
+            for (Vertex v : piece) mark[v] = inside;
+            std::vector<Vertex> order;
+            sweep(piece.front(), inside, seen, mark, order);
+            Vertex far = order.back();
+
+            inside = ++stamp;
+            seen = ++stamp;
+            for (Vertex v : piece) mark[v] = inside;
+            order.clear();
+            sweep(far, inside, seen, mark, order);
+            for (Vertex v : piece) {
+                if (mark[v] == inside) sweep(v, inside, seen, mark, order);
+            }
+
+            std::size_t half = order.size() / 2;
+            std::vector<Vertex> left(order.begin(), order.begin() + half);
+            std::vector<Vertex> right(order.begin() + half, order.end());
+            std::vector<Vertex>().swap(piece);
+            bisect(left, limit, mark, stamp, parts);
+            bisect(right, limit, mark, stamp, parts);
+        }
+
+        // Splits piece into cells of level k, then each of those into cells of the levels below
+        void partition(std::vector<Vertex>& piece, int k, const std::vector<std::size_t>& cell_sizes,
+                       std::vector<std::uint32_t>& mark, std::uint32_t& stamp, std::vector<std::uint32_t>& cells) {
+            std::vector<std::vector<Vertex>> parts;
+            bisect(piece, cell_sizes[k], mark, stamp, parts);
+            for (std::vector<Vertex>& part : parts) {
+                for (Vertex v : part) levels[k].cell[v] = cells[k];
+                cells[k]++;
+                if (k > 0) partition(part, k - 1, cell_sizes, mark, stamp, cells);
+            }
+        }
+
+        // Finds the boundary vertices of every cell and lays out the cliques
+        void build_boundary(Level& level, std::size_t num_cells) {
+            std::size_t n = G.num_vertices();
+            level.boundary_index.assign(n, NOT_BOUNDARY);
+            level.boundary_offsets.assign(num_cells + 1, 0);
+            std::vector<char> is_boundary(n, 0);
+            for (Vertex v = 0; v < n; v++) {
+                G.for_each_neighbor(v, [&](Vertex w, Weight) {
+                    if (level.cell[w] != level.cell[v]) is_boundary[v] = 1;
+                });
+                if (is_boundary[v]) level.boundary_offsets[level.cell[v] + 1]++;
+            }
+            for (std::size_t c = 0; c < num_cells; c++) level.boundary_offsets[c + 1] += level.boundary_offsets[c];
+            level.boundary.resize(level.boundary_offsets[num_cells]);
+            std::vector<std::uint64_t> cursor(level.boundary_offsets.begin(), level.boundary_offsets.end() - 1);
+            for (Vertex v = 0; v < n; v++) {
+                if (!is_boundary[v]) continue;
+                std::uint32_t c = level.cell[v];
+                level.boundary_index[v] = static_cast<std::uint32_t>(cursor[c] - level.boundary_offsets[c]);
+                level.boundary[cursor[c]++] = v;
+            }
+            level.clique_offsets.assign(num_cells + 1, 0);
+            for (std::size_t c = 0; c < num_cells; c++) {
+                std::uint64_t b = level.boundary_offsets[c + 1] - level.boundary_offsets[c];
+                level.clique_offsets[c + 1] = level.clique_offsets[c] + b * b;
+            }
+            level.clique.assign(level.clique_offsets[num_cells], 1.0 / 0.0);
+        }
+
+        // Calls f(w, weight) for every arc out of u in the overlay of level k: the clique of the level-k cell of u
+        // and the original edges leaving that cell. Level -1 is the original graph. Apart from level -1, u must
+        // be a boundary vertex of level k.
+        //
+        // A search that reached u from p along the clique skips the clique of u: clique distances are shortest
+        // paths inside the cell, so p's own arc to any w is no longer than going through u. Without this every
+        // boundary vertex of a cell would scan the whole clique again.
+        template <typename FUNCTION>
+        void for_each_overlay_arc(int k, Vertex u, Vertex p, FUNCTION&& f) const {
+            if (k < 0) {
+                G.for_each_neighbor(u, [&](Vertex w, Weight weight) { f(w, double(weight)); });
+                return;
+            }
+            const Level& level = levels[k];
+            std::uint32_t c = level.cell[u];
+            if (p == u or level.cell[p] != c) {
+                std::uint64_t first = level.boundary_offsets[c];
+                std::uint64_t b = level.boundary_offsets[c + 1] - first;
+                const double* row = level.clique.data() + level.clique_offsets[c] + level.boundary_index[u] * b;
+                for (std::uint64_t j = 0; j < b; j++) {
+                    if (row[j] != 1.0 / 0.0 and level.boundary[first + j] != u) f(level.boundary[first + j], row[j]);
+                }
+            }
+            G.for_each_neighbor(u, [&](Vertex w, Weight weight) {
+                if (level.cell[w] != c) f(w, double(weight));
+            });
+        }
+
+        // Dijkstra from 'from' on the overlay of level k - 1, restricted to the level-k cell of 'from', until
+        // done(u) returns true for a settled vertex u
+        template <unsigned ARITY, typename DONE>
+        void cell_search(int k, Vertex from, BasicQueryContext<ARITY>& ctx, DONE&& done) const {
+            const std::vector<std::uint32_t>& cell = levels[k].cell;
+            std::uint32_t c = cell[from];
+            IndexedHeap<double, ARITY>& pq = ctx.get_heap();
+            SearchStats& stats = ctx.get_stats();
+            ctx.reset();
+            ctx.label(from, 0, from);
+            pq.push(from, 0);
+            stats_count(stats.pushes);
+            while (!pq.empty()) {
+                Vertex u = pq.pop();
+                stats_count(stats.pops);
+                stats_count(stats.settled);
+                if (done(u)) return;
+                double du = ctx.get_dist(u);
+                for_each_overlay_arc(k - 1, u, ctx.get_prev(u), [&](Vertex w, double weight) {
+                    if (cell[w] != c) return;
+                    stats_count(stats.relaxations);
+                    double candidate = du + weight;
+                    if (candidate < ctx.get_dist(w)) {
+                        ctx.label(w, candidate, u);
+                        stats_count_push(stats, pq, w);
+                        pq.push_or_decrease(w, candidate);
+                    }
+                });
+            }
+        }
+
+        // Highest level whose cell of u holds neither v nor end; -1 if u shares its level-0 cell with one of them
+        int query_level(Vertex u, Vertex v, Vertex end) const {
+            for (int k = static_cast<int>(levels.size()) - 1; k >= 0; k--) {
+                const std::vector<std::uint32_t>& cell = levels[k].cell;
+                if (cell[u] != cell[v] and cell[u] != cell[end]) return k;
+            }
+            return -1;
+        }
+
+        // Appends the original path for the overlay arc x - y of level k, minus x, to path
+        template <unsigned ARITY>
+        void unpack(int k, Vertex x, Vertex y, BasicQueryContext<ARITY>& scratch, std::vector<Vertex>& path) const {
+            if (k < 0 or levels[k].cell[x] != levels[k].cell[y]) {
+                path.push_back(y);
+                return;
+            }
+            cell_search(k, x, scratch, [&](Vertex u) { return u == y; });
+            std::vector<Vertex> inside = scratch.path_to(y);
+            for (std::size_t i = 0; i + 1 < inside.size(); i++) unpack(k - 1, inside[i], inside[i + 1], scratch, path);
+        }
+
+    public:
+        // cell_sizes[k] is the most vertices a cell of level k may have, increasing with k; by default
+        // 2^8, 2^11, 2^14, ... for as long as a level still has at least 32 cells. Partitions the graph and
+        // customizes it for the current weights.
+        CustomizableRoutePlanner(const GRAPH& G, std::vector<std::size_t> cell_sizes = {}, unsigned threads = 0) : G(G) {
+            std::size_t n = G.num_vertices();
+            if (cell_sizes.empty()) {
+                for (std::size_t size = 1 << 8; size * 32 <= n; size <<= 3) cell_sizes.push_back(size);
+            }
+            for (std::size_t k = 1; k < cell_sizes.size(); k++) {
+                if (cell_sizes[k] <= cell_sizes[k - 1]) throw std::runtime_error("Cell sizes must increase with the level");
+            }
+            if (!cell_sizes.empty() and cell_sizes[0] == 0) throw std::runtime_error("Cell sizes must be positive");
+
+            levels.resize(cell_sizes.size());
+            for (Level& level : levels) level.cell.assign(n, 0);
+            if (!levels.empty()) {
+                std::vector<Vertex> all(n);
+                for (Vertex v = 0; v < n; v++) all[v] = v;
+                std::vector<std::uint32_t> mark(n, 0), cells(levels.size(), 0);
+                std::uint32_t stamp = 0;
+                partition(all, static_cast<int>(levels.size()) - 1, cell_sizes, mark, stamp, cells);
+                for (std::size_t k = 0; k < levels.size(); k++) build_boundary(levels[k], cells[k]);
+            }
+            customize(threads);
+        }
+
+        CustomizableRoutePlanner(const CustomizableRoutePlanner&) = delete;
+        CustomizableRoutePlanner& operator=(const CustomizableRoutePlanner&) = delete;
+
+        std::size_t num_vertices() const { return G.num_vertices(); }
+        std::size_t num_levels() const { return levels.size(); }
+        std::size_t num_cells(std::size_t k) const { return levels[k].num_cells(); }
+        std::size_t num_boundary_vertices(std::size_t k) const { return levels[k].boundary.size(); }
+        std::uint32_t get_cell(std::size_t k, Vertex v) const { return levels[k].cell[v]; }
+
+        // Recomputes every clique from the current weights, level by level, the cells of a level in parallel
+        void customize(ThreadPool& pool) {
+            std::vector<QueryContext> contexts(pool.size(), QueryContext(G.num_vertices()));
+            for (std::size_t k = 0; k < levels.size(); k++) {
+                Level& level = levels[k];
+                pool.parallel_for(0, level.num_cells(), [&](std::size_t c, unsigned thread) {
+                    QueryContext& ctx = contexts[thread];
+                    std::uint64_t first = level.boundary_offsets[c];
+                    std::uint64_t b = level.boundary_offsets[c + 1] - first;
+                    double* clique = level.clique.data() + level.clique_offsets[c];
+                    // Distances are symmetric, so the search from the i-th boundary vertex only has to settle
+                    // the ones from i on and fills in both halves of the matrix
+                    for (std::uint64_t i = 0; i < b; i++) {
+                        std::uint64_t left = b - i;
+                        cell_search(static_cast<int>(k), level.boundary[first + i], ctx, [&](Vertex u) {
+                            if (level.boundary_index[u] != NOT_BOUNDARY and level.boundary_index[u] >= i) left--;
+                            return left == 0;
+                        });
+                        for (std::uint64_t j = i; j < b; j++) {
+                            clique[i * b + j] = clique[j * b + i] = ctx.get_dist(level.boundary[first + j]);
+                        }
+                    }
+                }, 1);
+            }
+        }
+
+        void customize(unsigned threads = 0) {
+            ThreadPool pool(threads);
+            customize(pool);
+        }
+
+        // Bidirectional Dijkstra on the overlay seen from v and end: every settled vertex u relaxes the arcs of
+        // level query_level(u). Stops, as in bidirectional_dijkstra, once the two queue minima add up to the
+        // best meeting distance. Returns the distance (infinity if unreachable) and the unpacked path v..end.
+        // The contexts are reset first and can be reused across queries.
+        template <unsigned ARITY>
+        std::tuple<double, std::vector<Vertex>> Query(Vertex v, Vertex end, BasicQueryContext<ARITY>& forward, BasicQueryContext<ARITY>& backward) const {
+            double inf = 1.0 / 0.0;
+            std::size_t n = num_vertices();
+            if (v >= n or end >= n) { return std::tuple(inf, std::vector<Vertex>()); }
+            if (v == end) { return std::tuple(0.0, std::vector<Vertex>(1, v)); }
+
+            BasicQueryContext<ARITY>* ctx[2] = {&forward, &backward};
+            Vertex source[2] = {v, end};
+            for (int side = 0; side < 2; side++) {
+                ctx[side]->resize(n);
+                ctx[side]->reset();
+                ctx[side]->label(source[side], 0, source[side]);
+                ctx[side]->get_heap().push(source[side], 0);
+                stats_count(ctx[side]->get_stats().pushes);
+            }
+
+            double mu = inf;
+            Vertex meet = NO_VERTEX;
+            int side = 0;
+            while (!forward.get_heap().empty() and !backward.get_heap().empty()) {
+                if (forward.get_heap().top_key() + backward.get_heap().top_key() >= mu) break;
+                BasicQueryContext<ARITY>& here = *ctx[side];
+                const BasicQueryContext<ARITY>& other = *ctx[1 - side];
+                SearchStats& stats = here.get_stats();
+                Vertex u = here.get_heap().pop();
+                stats_count(stats.pops);
+                stats_count(stats.settled);
+                double du = here.get_dist(u);
+                for_each_overlay_arc(query_level(u, v, end), u, here.get_prev(u), [&](Vertex w, double weight) {
+                    stats_count(stats.relaxations);
+                    double candidate = du + weight;
+                    if (candidate < here.get_dist(w)) {
+                        here.label(w, candidate, u);
+                        stats_count_push(stats, here.get_heap(), w);
+                        here.get_heap().push_or_decrease(w, candidate);
+                    }
+                    if (candidate + other.get_dist(w) < mu) {
+                        mu = candidate + other.get_dist(w);
+                        meet = w;
+                    }
+                });
+                side = 1 - side;
+            }
+
+            std::vector<Vertex> path;
+            if (meet == NO_VERTEX) { return std::tuple(inf, path); }
+            std::vector<Vertex> overlay = forward.path_to(meet);
+            for (Vertex at = meet; at != end; ) {
+                at = backward.get_prev(at);
+                overlay.push_back(at);
+            }
+            // The forward labels are no longer needed, so its context serves the unpacking searches (and its
+            // counters end up including them)
+            path.push_back(v);
+            for (std::size_t i = 0; i + 1 < overlay.size(); i++) {
+                unpack(query_level(overlay[i], v, end), overlay[i], overlay[i + 1], forward, path);
+            }
+            return std::tuple(mu, path);
+        }
+
+        template <unsigned ARITY = 4>
+        std::tuple<double, std::vector<Vertex>> Query(Vertex v, Vertex end) const {
+            BasicQueryContext<ARITY> forward(num_vertices()), backward(num_vertices());
+            return Query(v, end, forward, backward);
+        }
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <tuple>
+#include <vector>
+#include "Dijkstra.hpp"
+#include "BidirectionalDijkstra.hpp"
+#include "ThreadPool.hpp"
+
+// Picks delta from the weight distribution: the largest weight over the average degree (Meyer & Sanders'
+// choice for random weights), kept between the smallest and largest weight. Small deltas approach Dijkstra,
+// large ones approach Bellman-Ford.
+template <typename GRAPH>
+double auto_delta(const GRAPH& G) {
+    std::size_t n = G.num_vertices();
+    double smallest = 1.0 / 0.0, largest = 0, slots = 0;
+    for (Vertex u = 0; u < n; u++) {
+        G.for_each_neighbor(u, [&](Vertex, Weight weight) {
+            slots++;
+            if (weight > 0 and weight < smallest) smallest = weight;
+            if (weight > largest) largest = weight;
+        });
+    }
+    if (slots == 0 or largest == 0) return 1;
+    double delta = largest / (slots / n);
+    if (delta < smallest) delta = smallest;
+    if (delta > largest) delta = largest;
+    return delta;
+}
+
+// Parallel one-to-all shortest paths by delta-stepping. Vertices sit in buckets of width delta by tentative
+// distance; the lowest non-empty bucket is emptied by relaxing its light edges (weight <= delta) in parallel
+// until it stays empty, then the heavy edges of everything it held are relaxed once. A relaxation from bucket
+// i lands at most ceil(max weight / delta) buckets further on, so the buckets are a ring of that many plus
+// one (and one spare for rounding), however long the paths get; a small heap of the non-empty buckets jumps
+// over the empty ones instead of stepping through them. Distance updates are
+// lock-free atomic minimums. prev is filled in afterwards from the final distances, so it is a valid
+// shortest path tree no matter how the relaxations interleaved. delta <= 0 picks one with auto_delta.
+template <typename GRAPH>
+std::tuple<std::vector<double>, std::vector<Vertex>> delta_stepping(const GRAPH& G, Vertex v, ThreadPool& pool, double delta = 0) {
+    double inf = 1.0 / 0.0;
+    std::size_t n = G.num_vertices();
+    std::vector<double> result(n, inf);
+    std::vector<Vertex> prev(n, NO_VERTEX);
+    if (v >= n) { return std::tuple(result, prev); }
+    if (delta <= 0) delta = auto_delta(G);
+    Weight max_weight = 0;
+    for (Vertex u = 0; u < n; u++) {
+        G.for_each_neighbor(u, [&](Vertex, Weight weight) {
+            if (weight > max_weight) max_weight = weight;
+        });
+    }
+    std::size_t ring = static_cast<std::size_t>(std::ceil(max_weight / delta)) + 2;
+
+    std::vector<std::atomic<double>> dist(n);
+    for (std::atomic<double>& d : dist) d.store(inf, std::memory_order_relaxed);
+    dist[v].store(0, std::memory_order_relaxed);
+
+    std::vector<std::vector<Vertex>> buckets(ring);
+    buckets[0].push_back(v);
+    // Buckets by absolute index, pushed when their slot goes from empty to non-empty; everything in a slot
+    // belongs to the same absolute bucket or an earlier one (stale entries)
+    std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<std::size_t>> nonempty;
+    nonempty.push(0);
+    std::vector<std::vector<Vertex>> improved(pool.size());
+    std::vector<char> in_frontier(n, 0), in_settled(n, 0);
+    auto bucket_of = [&](Vertex w) { return static_cast<std::size_t>(dist[w].load(std::memory_order_relaxed) / delta); };
+
+    auto relax = [&](Vertex w, double candidate, unsigned thread) {
+        double old = dist[w].load(std::memory_order_relaxed);
+        while (candidate < old) {
+            if (dist[w].compare_exchange_weak(old, candidate, std::memory_order_relaxed)) {
+                improved[thread].push_back(w);
+                return;
+            }
+        }
+    };
+    auto relax_all = [&](const std::vector<Vertex>& from, bool light) {
+        pool.parallel_for(0, from.size(), [&](std::size_t i, unsigned thread) {
+            Vertex u = from[i];
+            double du = dist[u].load(std::memory_order_relaxed);
+            G.for_each_neighbor(u, [&](Vertex w, Weight weight) {
+                if ((weight <= delta) == light) relax(w, du + weight, thread);
+            });
+        });
+        for (std::vector<Vertex>& list : improved) {
+            for (Vertex w : list) {
+                std::size_t b = bucket_of(w);
+                if (buckets[b % ring].empty()) nonempty.push(b);
+                buckets[b % ring].push_back(w);
+            }
+            list.clear();
+        }
+    };
+
+    std::vector<Vertex> frontier, settled;
+    while (!nonempty.empty()) {
+        std::size_t i = nonempty.top();
+        nonempty.pop();
+        std::vector<Vertex>& bucket = buckets[i % ring];
+        if (bucket.empty()) continue;  // pushed again while it was being emptied
+        settled.clear();
+        while (!bucket.empty()) {
+            frontier.clear();
+            for (Vertex u : bucket) {
+                // Skip duplicates and entries left behind when a vertex moved to a lower bucket
+                if (in_frontier[u] or bucket_of(u) != i) continue;
+                in_frontier[u] = 1;
+                frontier.push_back(u);
+                if (!in_settled[u]) {
+                    in_settled[u] = 1;
+                    settled.push_back(u);
+                }
+            }
+            bucket.clear();
+            for (Vertex u : frontier) in_frontier[u] = 0;
+            relax_all(frontier, true);
+        }
+        relax_all(settled, false);
+        for (Vertex u : settled) in_settled[u] = 0;
+    }
+
+    for (Vertex w = 0; w < n; w++) result[w] = dist[w].load(std::memory_order_relaxed);
+
+    // prev from tight edges into each vertex (its in-arcs on a directed graph). A vertex only reachable through
+    // zero-weight tight edges could pick a neighbor that picked it back, so those are attached afterwards by
+    // walking zero-weight edges out from the finished tree.
+    prev[v] = v;
+    std::atomic<bool> zero_only(false);
+    pool.parallel_for(0, n, [&](std::size_t i, unsigned) {
+        Vertex w = i;
+        if (w == v or result[w] == inf) return;
+        bool tight_zero = false;
+        for_each_in_neighbor(G, w, [&](Vertex u, Weight weight) {
+            if (result[u] + weight != result[w]) return;
+            if (weight > 0) prev[w] = u;
+            else tight_zero = true;
+        });
+        if (prev[w] == NO_VERTEX and tight_zero) zero_only.store(true, std::memory_order_relaxed);
+    }, 1024);
+    if (zero_only.load()) {
+        std::vector<Vertex> queue;
+        for (Vertex w = 0; w < n; w++) {
+            if (prev[w] != NO_VERTEX) queue.push_back(w);
+        }
+        for (std::size_t head = 0; head < queue.size(); head++) {
+            Vertex u = queue[head];
+            G.for_each_neighbor(u, [&](Vertex w, Weight weight) {
+                if (weight == 0 and prev[w] == NO_VERTEX and result[w] == result[u]) {
+                    prev[w] = u;
+                    queue.push_back(w);
+                }
+            });
+        }
+    }
+    return std::tuple(result, prev);
+}
+
+template <typename GRAPH>
+std::tuple<std::vector<double>, std::vector<Vertex>> delta_stepping(const GRAPH& G, Vertex v, double delta = 0, unsigned threads = 0) {
+    ThreadPool pool(threads);
+    return delta_stepping(G, v, pool, delta);
+}
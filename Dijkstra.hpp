@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include <tuple>
+#include "IndexedHeap.hpp"
+#include "QueryContext.hpp"
+
+using Vertex = unsigned long;
+using Weight = unsigned long;
+
+// Label-setting Dijkstra over any graph that provides num_vertices() and for_each_neighbor(u, f(w, weight)).
+// Every vertex is popped from the heap once and never revisited, a queued vertex gets its key lowered
+// instead of a duplicate entry, and the search stops as soon as 'end' is settled. Distances of vertices
+// that were still queued at that point are tentative upper bounds.
+template <unsigned ARITY = 4, typename GRAPH>
+std::tuple<std::vector<double>, std::vector<Vertex>> dijkstra(const GRAPH& G, Vertex v, Vertex end, SearchStats& stats) {
+    double inf = 1.0 / 0.0;  // Set this to infinity.
+    std::size_t n = G.num_vertices();
+    std::vector<double> dist;
+    std::vector<Vertex> prev;
+    IndexedHeap<double, ARITY> pq;
+    {
+        ScopedTimer timer(stats.setup_seconds);
+        dist.assign(n, inf);
+        prev.assign(n, NO_VERTEX);
+        pq.resize(n);
+    }
+    if (v >= n) { return std::tuple(dist, prev); }
+
+    ScopedTimer timer(stats.search_seconds);
+    dist[v] = 0;
+    prev[v] = v;
+    pq.push(v, 0);
+    stats_count(stats.pushes);
+    while (!pq.empty()) {
+        Vertex u = pq.pop();
+        stats_count(stats.pops);
+        stats_count(stats.settled);
+        if (u == end) break;
+        double du = dist[u];
+        G.for_each_neighbor(u, [&](Vertex w, Weight weight) {
+            stats_count(stats.relaxations);
+            double candidate = du + weight;
+            if (candidate < dist[w]) {
+                dist[w] = candidate;
+                prev[w] = u;
+                stats_count_push(stats, pq, w);
+                pq.push_or_decrease(w, candidate);
+            }
+        });
+    }
+    return std::tuple(dist, prev);
+}
+
+template <unsigned ARITY = 4, typename GRAPH>
+std::tuple<std::vector<double>, std::vector<Vertex>> dijkstra(const GRAPH& G, Vertex v, Vertex end = NO_VERTEX) {
+    SearchStats stats;
+    return dijkstra<ARITY>(G, v, end, stats);
+}
+
+// The same search on a reused QueryContext, so a query only pays for the vertices it reaches. The labels stay
+// in ctx (get_dist, get_prev, path_to) until its next reset. Returns the distance to 'end', infinite if it was
+// not reached.
+template <unsigned ARITY, typename GRAPH>
+double dijkstra(const GRAPH& G, Vertex v, Vertex end, BasicQueryContext<ARITY>& ctx) {
+    std::size_t n = G.num_vertices();
+    SearchStats& stats = ctx.get_stats();
+    {
+        ScopedTimer timer(stats.setup_seconds);
+        ctx.resize(n);
+        ctx.reset();
+    }
+    if (v >= n) { return 1.0 / 0.0; }
+
+    ScopedTimer timer(stats.search_seconds);
+    IndexedHeap<double, ARITY>& pq = ctx.get_heap();
+    ctx.label(v, 0, v);
+    pq.push(v, 0);
+    stats_count(stats.pushes);
+    while (!pq.empty()) {
+        Vertex u = pq.pop();
+        stats_count(stats.pops);
+        stats_count(stats.settled);
+        if (u == end) break;
+        double du = ctx.get_dist(u);
+        G.for_each_neighbor(u, [&](Vertex w, Weight weight) {
+            stats_count(stats.relaxations);
+            double candidate = du + weight;
+            if (candidate < ctx.get_dist(w)) {
+                ctx.label(w, candidate, u);
+                stats_count_push(stats, pq, w);
+                pq.push_or_decrease(w, candidate);
+            }
+        });
+    }
+    return end < n ? ctx.get_dist(end) : 1.0 / 0.0;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include "Graph.hpp"
+#include "CSRGraph.hpp"
+
+// One directed arc from -> to. Unlike Edge the endpoints keep their order.
+struct DirectedEdge {
+    Vertex from;
+    Vertex to;
+    Weight weight;
+};
+
+// A frozen directed graph for one-way streets: the out-arcs of every vertex in one packed CSR layout and its
+// in-arcs in a second one, so a backward search reads its rows as linearly as a forward search. Both layouts
+// are filled by the same counting sort, each arc written once into its tail's forward row and once into its
+// head's reverse row; there are no Edge objects. Same 32-bit packing as CSRGraph, so row() feeds the SIMD
+// kernels too.
+class DirectedGraph {
+    private:
+        std::vector<std::uint64_t> out_offsets;
+        std::vector<std::uint32_t> out_targets;
+        std::vector<std::uint32_t> out_weights;
+        std::vector<std::uint64_t> in_offsets;
+        std::vector<std::uint32_t> in_sources;
+        std::vector<std::uint32_t> in_weights;
+
+        static std::uint32_t narrow(unsigned long x, const char* what) {
+            if (x > std::numeric_limits<std::uint32_t>::max()) {
+                throw std::runtime_error(std::string(what) + " does not fit in 32 bits: " + std::to_string(x));
+            }
+            return static_cast<std::uint32_t>(x);
+        }
+
+        // Counts out- and in-degrees in one pass, prefix-sums both, then scatters every arc into both layouts in
+        // a second pass. each_arc(f) must call f(from, to, weight) for every arc, the same way on every call.
+        template <typename EACH_ARC>
+        void build(EACH_ARC&& each_arc, std::size_t num_vertices) {
+            each_arc([&](Vertex from, Vertex to, Weight) {
+                if (from >= num_vertices) num_vertices = from + 1;
+                if (to >= num_vertices) num_vertices = to + 1;
+            });
+            narrow(num_vertices, "Vertex count");
+            out_offsets.assign(num_vertices + 1, 0);
+            in_offsets.assign(num_vertices + 1, 0);
+            each_arc([&](Vertex from, Vertex to, Weight) {
+                out_offsets[from + 1]++;
+                in_offsets[to + 1]++;
+            });
+            for (std::size_t i = 0; i < num_vertices; i++) {
+                out_offsets[i + 1] += out_offsets[i];
+                in_offsets[i + 1] += in_offsets[i];
+            }
+            std::size_t m = out_offsets[num_vertices];
+            out_targets.resize(m);
+            out_weights.resize(m);
+            in_sources.resize(m);
+            in_weights.resize(m);
+            std::vector<std::uint64_t> out_cursor(out_offsets.begin(), out_offsets.end() - 1);
+            std::vector<std::uint64_t> in_cursor(in_offsets.begin(), in_offsets.end() - 1);
+            each_arc([&](Vertex from, Vertex to, Weight weight) {
+                std::uint32_t w = narrow(weight, "Edge weight");
+                std::uint64_t slot = out_cursor[from]++;
+                out_targets[slot] = static_cast<std::uint32_t>(to);
+                out_weights[slot] = w;
+                slot = in_cursor[to]++;
+                in_sources[slot] = static_cast<std::uint32_t>(from);
+                in_weights[slot] = w;
+            });
+        }
+
+    public:
+        DirectedGraph() : out_offsets(1, 0), in_offsets(1, 0) {}
+
+        // num_vertices may be larger than the highest id to keep trailing isolated vertices
+        DirectedGraph(const std::vector<DirectedEdge>& arcs, std::size_t num_vertices = 0) {
+            build([&](auto&& f) {
+                for (const DirectedEdge& a : arcs) f(a.from, a.to, a.weight);
+            }, num_vertices);
+        }
+
+        // Builds straight from several arc batches (e.g. one per loader thread) without concatenating them first
+        DirectedGraph(const std::vector<std::vector<DirectedEdge>>& arc_chunks, std::size_t num_vertices = 0) {
+            build([&](auto&& f) {
+                for (const std::vector<DirectedEdge>& chunk : arc_chunks) {
+                    for (const DirectedEdge& a : chunk) f(a.from, a.to, a.weight);
+                }
+            }, num_vertices);
+        }
+
+        // Both directions of every edge of an undirected graph
+        DirectedGraph(Graph& G) {
+            const std::vector<Edge>& edges = G.get_data();
+            build([&](auto&& f) {
+                for (const Edge& e : edges) {
+                    f(e.get_left(), e.get_right(), e.get_weight());
+                    if (e.get_left() != e.get_right()) f(e.get_right(), e.get_left(), e.get_weight());
+                }
+            }, G.num_vertices());
+        }
+
+        std::size_t num_vertices() const { return out_offsets.size() - 1; }
+        std::size_t num_arcs() const { return out_targets.size(); }
+        std::size_t out_degree(Vertex v) const { return out_offsets[v + 1] - out_offsets[v]; }
+        std::size_t in_degree(Vertex v) const { return in_offsets[v + 1] - in_offsets[v]; }
+
+        // Calls f(w, weight) for every arc v -> w
+        template <typename FUNCTION>
+        void for_each_neighbor(Vertex v, FUNCTION&& f) const {
+            std::uint64_t end = out_offsets[v + 1];
+            for (std::uint64_t i = out_offsets[v]; i < end; i++) {
+                f(static_cast<Vertex>(out_targets[i]), static_cast<Weight>(out_weights[i]));
+            }
+        }
+
+        // Calls f(u, weight) for every arc u -> v
+        template <typename FUNCTION>
+        void for_each_in_neighbor(Vertex v, FUNCTION&& f) const {
+            std::uint64_t end = in_offsets[v + 1];
+            for (std::uint64_t i = in_offsets[v]; i < end; i++) {
+                f(static_cast<Vertex>(in_sources[i]), static_cast<Weight>(in_weights[i]));
+            }
+        }
+
+        PackedRow row(Vertex v) const { return PackedRow{out_targets.data() + out_offsets[v], out_weights.data() + out_offsets[v], out_degree(v)}; }
+        PackedRow in_row(Vertex v) const { return PackedRow{in_sources.data() + in_offsets[v], in_weights.data() + in_offsets[v], in_degree(v)}; }
+
+        std::size_t memory_bytes() const {
+            return (out_offsets.size() + in_offsets.size()) * sizeof(std::uint64_t) +
+                   (out_targets.size() + out_weights.size() + in_sources.size() + in_weights.size()) * sizeof(std::uint32_t);
+        }
+
+        template <unsigned ARITY = 4>
+        std::tuple<std::vector<double>, std::vector<Vertex>> Dijkstra(Vertex v, Vertex end) const {
+            return dijkstra<ARITY>(*this, v, end);
+        }
+
+        // Distances from every vertex to v: Dijkstra along the reverse arcs. prev[u] is the next vertex after u on
+        // its shortest path to v.
+        std::tuple<std::vector<double>, std::vector<Vertex>> ReverseDijkstra(Vertex v, Vertex end = NO_VERTEX) const {
+            return dijkstra(ReverseGraph<DirectedGraph>(*this), v, end);
+        }
+
+        template <unsigned ARITY = 4>
+        std::tuple<double, std::vector<Vertex>> BidirectionalDijkstra(Vertex v, Vertex end) const {
+            return bidirectional_dijkstra<ARITY>(*this, v, end);
+        }
+};
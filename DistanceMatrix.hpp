@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vector>
+#include "Dijkstra.hpp"
+#include "ContractionHierarchy.hpp"
+#include "ThreadPool.hpp"
+
+// Fills out[i * targets.size() + j] with the distance from sources[i] to targets[j] (infinity if unreachable).
+// Sources are spread over the pool, one Dijkstra each on a per-thread QueryContext, and every search stops as
+// soon as it has settled all of the targets. ARITY is the arity of their heaps.
+template <unsigned ARITY = 4, typename GRAPH>
+void distance_matrix(const GRAPH& G, const std::vector<Vertex>& sources, const std::vector<Vertex>& targets, double* out, ThreadPool& pool) {
+    std::size_t n = G.num_vertices();
+    std::size_t m = targets.size();
+    std::vector<char> is_target(n, 0);
+    std::size_t distinct = 0;
+    for (Vertex t : targets) {
+        if (t < n and !is_target[t]) {
+            is_target[t] = 1;
+            distinct++;
+        }
+    }
+
+    std::vector<BasicQueryContext<ARITY>> contexts(pool.size(), BasicQueryContext<ARITY>(n));
+    pool.parallel_for(0, sources.size(), [&](std::size_t i, unsigned thread) {
+        BasicQueryContext<ARITY>& ctx = contexts[thread];
+        IndexedHeap<double, ARITY>& pq = ctx.get_heap();
+        ctx.reset();
+        Vertex s = sources[i];
+        if (s < n) {
+            std::size_t left = distinct;
+            ctx.label(s, 0, s);
+            pq.push(s, 0);
+            while (!pq.empty() and left > 0) {
+                Vertex u = pq.pop();
+                if (is_target[u]) left--;
+                double du = ctx.get_dist(u);
+                G.for_each_neighbor(u, [&](Vertex w, Weight weight) {
+                    double candidate = du + weight;
+                    if (candidate < ctx.get_dist(w)) {
+                        ctx.label(w, candidate, u);
+                        pq.push_or_decrease(w, candidate);
+                    }
+                });
+            }
+        }
+        double* row = out + i * m;
+        for (std::size_t j = 0; j < m; j++) {
+            row[j] = s < n and targets[j] < n ? ctx.get_dist(targets[j]) : 1.0 / 0.0;
+        }
+    }, 1);
+}
+
+// Upward search in a contraction hierarchy with stall-on-demand; calls visit(x, d) for every vertex settled
+// and not stalled, which includes the top vertex of every shortest path from s with its exact distance
+template <unsigned ARITY, typename VISIT>
+void upward_search(const ContractionHierarchy& CH, Vertex s, BasicQueryContext<ARITY>& ctx, VISIT&& visit) {
+    IndexedHeap<double, ARITY>& pq = ctx.get_heap();
+    ctx.reset();
+    ctx.label(s, 0, s);
+    pq.push(s, 0);
+    while (!pq.empty()) {
+        Vertex u = pq.pop();
+        double du = ctx.get_dist(u);
+        bool stalled = false;
+        CH.for_each_up(u, [&](Vertex w, Weight weight, Vertex) {
+            if (ctx.get_dist(w) + weight < du) stalled = true;
+        });
+        if (stalled) continue;
+        visit(u, du);
+        CH.for_each_up(u, [&](Vertex w, Weight weight, Vertex) {
+            double candidate = du + weight;
+            if (candidate < ctx.get_dist(w)) {
+                ctx.label(w, candidate, u);
+                pq.push_or_decrease(w, candidate);
+            }
+        });
+    }
+}
+
+// Bucket-based many-to-many over a contraction hierarchy (Knopp et al.): every target's upward search
+// leaves (target, distance) entries in buckets at the vertices it settles, then every source's upward
+// search scans the buckets it meets. Each shortest path meets its top vertex in both searches.
+inline void distance_matrix(const ContractionHierarchy& CH, const std::vector<Vertex>& sources, const std::vector<Vertex>& targets, double* out, ThreadPool& pool) {
+    struct Entry {
+        Vertex vertex;
+        std::size_t target;
+        double dist;
+    };
+    std::size_t n = CH.num_vertices();
+    std::size_t m = targets.size();
+    std::vector<QueryContext> contexts(pool.size(), QueryContext(n));
+
+    std::vector<std::vector<Entry>> found(pool.size());
+    pool.parallel_for(0, m, [&](std::size_t j, unsigned thread) {
+        if (targets[j] >= n) return;
+        upward_search(CH, targets[j], contexts[thread], [&](Vertex x, double d) {
+            found[thread].push_back(Entry{x, j, d});
+        });
+    }, 1);
+
+    // Counting sort of the entries into one bucket per vertex
+    std::vector<std::size_t> offsets(n + 1, 0);
+    for (const std::vector<Entry>& list : found) {
+        for (const Entry& e : list) offsets[e.vertex + 1]++;
+    }
+    for (std::size_t x = 0; x < n; x++) offsets[x + 1] += offsets[x];
+    std::vector<std::pair<std::size_t, double>> buckets(offsets[n]);
+    std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (const std::vector<Entry>& list : found) {
+        for (const Entry& e : list) buckets[cursor[e.vertex]++] = {e.target, e.dist};
+    }
+    found.clear();
+
+    pool.parallel_for(0, sources.size(), [&](std::size_t i, unsigned thread) {
+        double* row = out + i * m;
+        for (std::size_t j = 0; j < m; j++) row[j] = 1.0 / 0.0;
+        if (sources[i] >= n) return;
+        upward_search(CH, sources[i], contexts[thread], [&](Vertex x, double d) {
+            for (std::size_t b = offsets[x]; b < offsets[x + 1]; b++) {
+                double through = d + buckets[b].second;
+                if (through < row[buckets[b].first]) row[buckets[b].first] = through;
+            }
+        });
+    }, 1);
+}
+
+template <unsigned ARITY = 4, typename GRAPH>
+void distance_matrix(const GRAPH& G, const std::vector<Vertex>& sources, const std::vector<Vertex>& targets, double* out, unsigned threads = 0) {
+    ThreadPool pool(threads);
+    distance_matrix<ARITY>(G, sources, targets, out, pool);
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <exception>
+#include <map>
+#include <vector>
+#include <tuple>
+#include "Graph.hpp"
+
+enum class UpdateKind { SET_WEIGHT, INSERT, REMOVE };
+
+// One change to the graph: a new weight for the edge v - u, a new edge v - u, or the removal of one
+struct EdgeUpdate {
+    UpdateKind kind;
+    Vertex v;
+    Vertex u;
+    Weight weight;  // ignored for REMOVE
+};
+
+// A single-source shortest path tree that is kept up to date while the graph changes, in the spirit of
+// Ramalingam & Reps. A batch of updates is applied to the graph, then only the part of the tree it can
+// affect is repaired:
+//   - a tree edge that got longer or disappeared invalidates the subtree below it; those vertices are reset
+//     and re-seeded from their best neighbor outside the subtree;
+//   - an edge that got shorter or was added seeds its endpoints if it now gives a shorter path;
+// and one Dijkstra pass from the seeds settles everything whose distance changed. Changes that touch no
+// tree edge and shorten nothing return straight after updating the graph.
+class DynamicShortestPaths {
+    private:
+        Graph& G;
+        Vertex source;
+        std::vector<double> dist;
+        std::vector<Vertex> prev;
+        IndexedHeap<double, 4> heap;
+        std::vector<char> affected;
+
+        void grow() {
+            std::size_t n = G.num_vertices();
+            if (n <= dist.size()) return;
+            dist.resize(n, 1.0 / 0.0);
+            prev.resize(n, NO_VERTEX);
+            affected.resize(n, 0);
+            heap.resize(n);
+        }
+
+        void improve(Vertex w, double candidate, Vertex from) {
+            if (candidate < dist[w]) {
+                dist[w] = candidate;
+                prev[w] = from;
+                heap.push_or_decrease(w, candidate);
+            }
+        }
+
+        // Marks the tree below (and including) root, following prev links downward through the graph's edges
+        void collect_subtree(Vertex root, std::vector<Vertex>& subtree) {
+            affected[root] = 1;
+            std::size_t first = subtree.size();
+            subtree.push_back(root);
+            for (std::size_t i = first; i < subtree.size(); i++) {
+                Vertex x = subtree[i];
+                G.for_each_neighbor(x, [&](Vertex w, Weight) {
+                    if (!affected[w] and w != x and prev[w] == x) {
+                        affected[w] = 1;
+                        subtree.push_back(w);
+                    }
+                });
+            }
+        }
+
+        // Repairs dist/prev after the graph changed: 'longer' holds the edges that got longer or disappeared with
+        // their weight before the batch, 'shorter' the endpoints of edges that got shorter or were added
+        std::size_t repair(const std::vector<std::tuple<Vertex, Vertex, Weight>>& longer, const std::vector<Vertex>& shorter) {
+            // Subtrees cut off by tree edges that got longer or disappeared. An edge only counts as a tree edge
+            // if it was tight; when a parallel edge was the real one this only costs a little extra work.
+            std::vector<Vertex> subtree;
+            for (const auto& [v, u, old] : longer) {
+                for (auto [x, y] : {std::pair(v, u), std::pair(u, v)}) {
+                    if (y != source and !affected[y] and prev[y] == x and dist[y] == dist[x] + old) {
+                        collect_subtree(y, subtree);
+                    }
+                }
+            }
+            if (subtree.empty()) {
+                // Fast path: nothing lost its path; only the shortened edges can change anything
+                bool any = false;
+                for (Vertex x : shorter) {
+                    G.for_each_neighbor(x, [&](Vertex w, Weight weight) {
+                        if (dist[x] + weight < dist[w] or dist[w] + weight < dist[x]) any = true;
+                    });
+                }
+                if (!any) return 0;
+            }
+
+            for (Vertex x : subtree) {
+                dist[x] = 1.0 / 0.0;
+                prev[x] = NO_VERTEX;
+            }
+            for (Vertex x : subtree) {
+                G.for_each_neighbor(x, [&](Vertex w, Weight weight) {
+                    if (!affected[w]) improve(x, dist[w] + weight, w);
+                });
+            }
+            for (Vertex x : subtree) affected[x] = 0;
+            for (Vertex x : shorter) {
+                G.for_each_neighbor(x, [&](Vertex w, Weight weight) {
+                    improve(w, dist[x] + weight, x);
+                    improve(x, dist[w] + weight, w);
+                });
+            }
+
+            std::size_t repaired = 0;
+            while (!heap.empty()) {
+                Vertex u = heap.pop();
+                repaired++;
+                double du = dist[u];
+                G.for_each_neighbor(u, [&](Vertex w, Weight weight) { improve(w, du + weight, u); });
+            }
+            // Subtree vertices that found no way back stay unreachable
+            for (Vertex x : subtree) {
+                if (dist[x] == 1.0 / 0.0) repaired++;
+            }
+            return repaired;
+        }
+
+    public:
+        DynamicShortestPaths(Graph& G, Vertex source) : G(G), source(source) {
+            std::tie(dist, prev) = G.Dijkstra(source, NO_VERTEX);
+            heap.resize(G.num_vertices());
+            affected.assign(G.num_vertices(), 0);
+        }
+
+        Vertex get_source() const { return source; }
+        const std::vector<double>& get_dist() const { return dist; }
+        const std::vector<Vertex>& get_prev() const { return prev; }
+
+        // Applies the batch to the graph in order and repairs dist/prev. Returns the number of vertices whose
+        // labels were recomputed (0 on the fast path). If an update fails (e.g. it names a missing edge), the
+        // updates before it stay applied, the tree is repaired for them, and the exception is passed on.
+        std::size_t apply(const std::vector<EdgeUpdate>& updates) {
+            std::vector<std::tuple<Vertex, Vertex, Weight>> longer;  // (v, u, weight before the batch)
+            std::vector<Vertex> shorter;                             // endpoints of shorter or new edges
+            // dist still describes the graph before the batch, so an edge changed twice must be checked
+            // against the weight it had then, not the one the previous update left
+            std::map<std::pair<Vertex, Vertex>, Weight> before;
+            auto first_weight = [&](Vertex v, Vertex u, Weight old) {
+                return before.emplace(std::pair(std::min(v, u), std::max(v, u)), old).first->second;
+            };
+            std::exception_ptr failure;
+            try {
+                for (const EdgeUpdate& update : updates) {
+                    if (update.kind == UpdateKind::SET_WEIGHT) {
+                        Weight old = G.set_weight(update.v, update.u, update.weight);
+                        Weight original = first_weight(update.v, update.u, old);
+                        if (update.weight > old) longer.push_back(std::tuple(update.v, update.u, original));
+                        if (update.weight < old) {
+                            shorter.push_back(update.v);
+                            shorter.push_back(update.u);
+                        }
+                    }
+                    else if (update.kind == UpdateKind::INSERT) {
+                        G.add_element(Edge(update.v, update.u, update.weight));
+                        grow();
+                        shorter.push_back(update.v);
+                        shorter.push_back(update.u);
+                    }
+                    else {
+                        Weight old = G.remove_element(update.v, update.u);
+                        longer.push_back(std::tuple(update.v, update.u, first_weight(update.v, update.u, old)));
+                    }
+                }
+            }
+            catch (...) {
+                failure = std::current_exception();
+            }
+            std::size_t repaired = repair(longer, shorter);
+            if (failure) std::rethrow_exception(failure);
+            return repaired;
+        }
+};
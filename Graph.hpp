@@ -1,9 +1,19 @@
+#pragma once
+
 #include <iostream>
 #include <vector>
 #include <algorithm>
 #include <queue>
+#include <memory>
+#include <stdexcept>
+#include "Arena.hpp"
 #include "UnionFind.hpp"
 #include "Compare.hpp"
+#include "Dijkstra.hpp"
+#include "BidirectionalDijkstra.hpp"
+#include "AStar.hpp"
+#include "DeltaStepping.hpp"
+#include "IntegerDijkstra.hpp"
 
 void print_path(const std::vector<Vertex> &path) {
     std::cout << "Path: ";
@@ -38,7 +48,7 @@ class Edge {
 
         Vertex get_left() const { return v; }
         Vertex get_right() const { return u; }
-        Weight get_weight() { return weight; }
+        Weight get_weight() const { return weight; }
         Vertex get_other(Vertex v) const { 
             if (this->get_left() == v) { return this->get_right(); }
             if (this->get_right() == v) { return this->get_left(); }
@@ -81,37 +91,143 @@ std::ostream& operator<<(std::ostream& os, const Edge& e) {
     return os;
 }
 
+// Neighbor lists are carved out of the graph's Arena
+using AdjacencyList = std::vector<Edge, ArenaAllocator<Edge>>;
+
 // The input set for a Graphic Matroid
 class Graph {
     private:
         std::vector<Edge> edges;
         UnionFind union_set;
-        std::vector<std::vector<Edge>> adj;
+        std::unique_ptr<Arena> arena = std::make_unique<Arena>();
+        std::vector<AdjacencyList> adj;
+        bool edges_stale = false;  // weights changed or edges removed in adj since 'edges' was last rebuilt
+
+        static constexpr std::size_t NOT_FOUND = static_cast<std::size_t>(-1);
+
+        // Position in adj[v] of the first edge to u, counting self loops (listed twice in adj[v]) only once
+        std::size_t find_edge(Vertex v, Vertex u) const {
+            if (v >= adj.size() or u >= adj.size()) return NOT_FOUND;
+            for (std::size_t i = 0; i < adj[v].size(); i++) {
+                if (adj[v][i].get_other(v) == u) return i;
+            }
+            return NOT_FOUND;
+        }
+
+        // The copy of the same edge in adj[u]: parallel edges sit in both lists in the order they were added
+        std::size_t find_twin(Vertex v, Vertex u, std::size_t i) const {
+            if (v == u) return i + 1;
+            std::size_t rank = 0;
+            for (std::size_t j = 0; j < i; j++) {
+                if (adj[v][j].get_other(v) == u) rank++;
+            }
+            for (std::size_t j = 0; j < adj[u].size(); j++) {
+                if (adj[u][j].get_other(u) == v and rank-- == 0) return j;
+            }
+            return NOT_FOUND;
+        }
+
+        // Each edge once, taken from the lower numbered endpoint's list (every other copy for self loops)
+        void rebuild_edges() {
+            edges.clear();
+            for (Vertex v = 0; v < adj.size(); v++) {
+                bool second_copy = false;
+                for (const Edge& e : adj[v]) {
+                    if (e.get_right() != v) continue;
+                    if (e.get_left() == v) {
+                        second_copy = !second_copy;
+                        if (!second_copy) continue;
+                    }
+                    edges.push_back(e);
+                }
+            }
+            edges_stale = false;
+        }
+
+        // New vertices get empty lists that allocate from the arena
+        void grow_to(std::size_t num_vertices) {
+            if (num_vertices <= adj.size()) return;
+            if (num_vertices > adj.capacity()) adj.reserve(std::max(num_vertices, 2 * adj.capacity()));
+            while (adj.size() < num_vertices) adj.emplace_back(ArenaAllocator<Edge>(arena.get()));
+        }
+
+        // Two-pass bulk insert: count vertices and degrees first, size every array exactly once, then fill.
+        // each_edge(f) must call f(edge) for every edge, the same way on every call.
+        template <typename EACH_EDGE>
+        void build(EACH_EDGE&& each_edge) {
+            std::size_t num_vertices = adj.size(), num_edges = 0;
+            each_edge([&](const Edge& e) {
+                if (e.get_left() >= num_vertices) num_vertices = e.get_left() + 1;
+                num_edges++;
+            });
+            std::vector<std::size_t> degree(num_vertices, 0);
+            each_edge([&](const Edge& e) {
+                degree[e.get_left()]++;
+                degree[e.get_right()]++;
+            });
+            reserve(num_vertices, edges.size() + num_edges);
+            for (Vertex v = 0; v < num_vertices; v++) {
+                if (degree[v] > 0) adj[v].reserve(adj[v].size() + degree[v]);
+            }
+            each_edge([&](const Edge& e) { this->add_element(e); });
+        }
+
     public:
         Graph() {}
-        Graph(int size) : union_set(UnionFind(size)), adj(size) {}
-        Graph(std::vector<std::tuple<Vertex, Vertex, Weight>> input_data) : union_set(UnionFind(input_data.size())) {
-            for (auto x : input_data) {
-                Edge e = Edge(std::get<0>(x), std::get<1>(x), std::get<2>(x));
-                this->add_element(e);
-                union_set.union_operation(e.get_left(), e.get_right());
-                adj[e.get_left()].push_back(e);
-                adj[e.get_right()].push_back(e);
-            }
+        Graph(int size) : union_set(UnionFind(size)) { grow_to(size); }
+        Graph(const std::vector<std::tuple<Vertex, Vertex, Weight>>& input_data) {
+            build([&](auto&& f) {
+                for (const auto& x : input_data) f(Edge(std::get<0>(x), std::get<1>(x), std::get<2>(x)));
+            });
+        }
+        // num_vertices may be larger than the highest id to keep trailing isolated vertices
+        Graph(const std::vector<Edge>& input_data, std::size_t num_vertices = 0) {
+            union_set.reserve(num_vertices);
+            grow_to(num_vertices);
+            build([&](auto&& f) {
+                for (const Edge& e : input_data) f(e);
+            });
+        }
+        // Builds straight from several edge batches (e.g. one per loader thread) without concatenating them first
+        Graph(const std::vector<std::vector<Edge>>& edge_chunks) {
+            build([&](auto&& f) {
+                for (const std::vector<Edge>& chunk : edge_chunks) {
+                    for (const Edge& e : chunk) f(e);
+                }
+            });
         }
-        Graph(std::vector<Edge> input_data) : union_set(UnionFind(input_data.size())) {
-            // for (int i = 0; i < input_data.size(); i++) {
-            //     adj.r
-            // }
-            adj.resize(input_data.size()*2);
-            for (Edge e : input_data) {
-                this->add_element(e);
-                union_set.union_operation(e.get_left(), e.get_right());
-                adj[e.get_left()].push_back(e);
-                adj[e.get_right()].push_back(e);
+
+        // A copy gets its own arena; its lists start out on the heap (see ArenaAllocator)
+        Graph(const Graph& other) : edges(other.edges), union_set(other.union_set), adj(other.adj), edges_stale(other.edges_stale) {}
+        Graph(Graph&&) = default;
+        // Assignment starts a fresh arena, since the old lists' memory can only be given back all at once
+        Graph& operator=(const Graph& other) {
+            if (this != &other) {
+                edges = other.edges;
+                union_set = other.union_set;
+                adj.clear();
+                arena = std::make_unique<Arena>();
+                grow_to(other.adj.size());
+                for (std::size_t v = 0; v < other.adj.size(); v++) adj[v].assign(other.adj[v].begin(), other.adj[v].end());
+                edges_stale = other.edges_stale;
             }
+            return *this;
+        }
+        Graph& operator=(Graph&&) = default;
+
+        // Makes room for num_vertices vertices and num_edges edges in total, so adding them reallocates nothing
+        // but the neighbor lists. Prefer the bulk constructors, which also size every neighbor list exactly.
+        void reserve(std::size_t num_vertices, std::size_t num_edges) {
+            edges.reserve(num_edges);
+            union_set.reserve(num_vertices);
+            grow_to(num_vertices);
         }
 
+        // Bytes held by the neighbor list arena. Lists grown one add_element at a time leave every outgrown
+        // buffer behind in it (freeing is a no-op), about twice their final size in total; the bulk
+        // constructors size each list once, and copies are compact.
+        std::size_t arena_bytes() const { return arena ? arena->bytes_reserved() : 0; }
+
         // // Matroid functions begin --------------------------------------------------------------------------------------------------
         // void min_sort() {
         //     std::sort(edges.begin(), edges.end(), MinCompare<Edge>{});
@@ -140,13 +256,43 @@ class Graph {
         //     return (!(union_set.find_operation(e.get_left()) == union_set.find_operation(e.get_right())));
         // }   
 
+        // Adds one edge. The neighbor lists grow by doubling inside the arena, see arena_bytes().
         void add_element(Edge e) {
             edges.push_back(e);
             union_set.union_operation(e.get_left(), e.get_right());
+            // The left vertex is always the larger one, so adj only grows to the highest vertex id seen
+            grow_to(e.get_left() + 1);
             adj[e.get_left()].push_back(e);
             adj[e.get_right()].push_back(e);
         }
 
+        // Changes the weight of the edge between v and u (the first one added, if there are parallel edges) and
+        // returns its old weight. O(degree); the edge list behind get_data() catches up on its next use.
+        Weight set_weight(Vertex v, Vertex u, Weight weight) {
+            std::size_t i = find_edge(v, u);
+            if (i == NOT_FOUND) { throw std::runtime_error("No edge " + std::to_string(v) + " - " + std::to_string(u)); }
+            std::size_t j = find_twin(v, u, i);
+            Weight old = adj[v][i].get_weight();
+            adj[v][i].set_weight(weight);
+            adj[u][j].set_weight(weight);
+            edges_stale = true;
+            return old;
+        }
+
+        // Removes the edge between v and u (the first one added, if there are parallel edges) and returns its
+        // weight. The union-find cannot split, so connected() stays true for vertices this disconnects.
+        Weight remove_element(Vertex v, Vertex u) {
+            std::size_t i = find_edge(v, u);
+            if (i == NOT_FOUND) { throw std::runtime_error("No edge " + std::to_string(v) + " - " + std::to_string(u)); }
+            std::size_t j = find_twin(v, u, i);
+            Weight old = adj[v][i].get_weight();
+            // Erase the later position first so a self loop's two copies keep their places until removed
+            adj[u].erase(adj[u].begin() + j);
+            adj[v].erase(adj[v].begin() + i);
+            edges_stale = true;
+            return old;
+        }
+
         // void pop() {
         //     edges.pop_back();
         // }
@@ -154,16 +300,17 @@ class Graph {
 
 
         std::vector<Edge>& get_data() {
+            if (edges_stale) rebuild_edges();
             return edges;
         }
 
-        std::vector<std::vector<Edge>>& get_adj() {
+        std::vector<AdjacencyList>& get_adj() {
             return adj;
         }
 
         std::string get_string() {
             std::string str = "";
-            for (auto edge : edges) {
+            for (auto edge : get_data()) {
                 str += edge.get_string() + " ";
             }
             str += "\n";
@@ -178,179 +325,62 @@ class Graph {
         }
 
         
-        std::tuple<std::vector<double>, std::vector<Vertex>> Dijkstra(Vertex v, Vertex end) {
-            // Basically without heuristics just push things onto a heap and perform on each turn the lowest one, popping each time and adding neighbors to the heap.
-            // std::vector<Vertex> path(1, v);
-            // UnionFind union_collection;
-            // std::priority_queue<Edge, std::vector<Edge>, Compare<Edge>> pq;
-            // int counter = edges.size();
-            // while (true) {
-            //     print_path(path);
-            //     for (Vertex u : path) {
-            //         for (Edge& e : adj[u]) {
-            //             if (union_collection.find_operation(e.get_left()) != union_collection.find_operation(e.get_right())) {
-            //                 // std::cout << union_collection.find_operation(e.get_left()) << std::endl;
-            //                 std::cout << e.get_left() << std::endl;
-            //                 std::cout << e.get_right() << std::endl;
-            //                 pq.push(e);
-            //             }
-            //         }
-            //     }
-            //     std::cout << pq.top() << std::endl;
-
-            //     // Now we make a decision and repeat
-            //     if (union_collection.is_empty()) {
-            //         union_collection.union_operation(v, pq.top().get_other(v));
-            //         path.push_back(pq.top().get_other(v));
-            //         pq.pop();
-            //         continue;
-            //     }
-            //     Vertex left = pq.top().get_left();
-            //     Vertex right = pq.top().get_right();
-            //     // If there is a cycle or a used edge
-            //     // while (union_collection.find_operation(left) == union_collection.find_operation(v) and union_collection.find_operation(right) == union_collection.find_operation(v)) {
-            //     //     pq.pop();
-            //     //     left = pq.top().get_left();
-            //     //     right = pq.top().get_right();
-            //     // }
-            //     // If the left vertex is already in the used vertices
-            //     if (union_collection.find_operation(left) == union_collection.find_operation(v)) { // the old (used) vertex
-            //         path.push_back(right); // the new vertex
-            //         if (right == end) { // Then we have found the end point and we return the best path we found
-            //             // path.push_back(end);
-            //             return path;
-            //         }
-            //         std::cout << "here" << std::endl;
-            //         union_collection.union_operation(right, v);
-            //     }
-            //     // If the right vertex is already in the used vertices
-            //     else if (union_collection.find_operation(right) == union_collection.find_operation(v)) { // the old (used) vertex
-            //         path.push_back(left); // the new vertex
-            //         if (left == end) { // Then we have found the end point and we return the best path we found
-            //             // path.push_back(end);
-            //             return path; 
-            //         }
-            //         union_collection.union_operation(left, v);
-
-            //     }
-            //     pq.pop();
-            //     counter--;
-            //     if (counter < 0) {
-            //         std::cout << "fail" << std::endl;
-            //         return path;
-            //     }
-            // }
-            // return path;
-            // Once done, add lots of heuristics and test. Then add a fancy visual and keep testing.
-            // Once done, study and add the neural network.
-            // If possible, try to integrate this into osm stuff.
-
-
-            double inf = 1.0/ 0.0;  // Set this to infinity.
-            std::vector<double> dist(adj.size(), inf);
-            std::vector<Vertex> prev(adj.size(), -1);
-
-            // Contains previous wedges and their weights for adding to 'count' variable // Actually not needed if you use dist and prev
-            // std::vector<std::tuple<Weighted_Edge, double>> prev_edges(G.V(), std::tuple<Weighted_Edge, double>());
-
-            // Update with starting vertex
-            dist[v] = 0; // update dist
-            prev[v] = v; // update prev
-
-            // The minimum priority queue pq stores the edges by edge weight.
-            auto compare = [](Edge e, Edge f) {return (e.get_weight() > f.get_weight());};
-            std::priority_queue<Edge, std::vector<Edge>, decltype(compare)> pq(compare);
-
-            // A union set for partitioning
-            UnionFind union_set = UnionFind(adj.size());
-
-            // A set of used vertices
-            std::vector<Vertex> pivot_vertices = {v};
-            // TODO UnionFind pivot_union = UnionFind(adj.size());
-
-            std::cout << adj.size() << "he" << std::endl;
-            // Iterate through number of 'turns'
-            for (int i = 0; i < adj.size()-1; i++) {
-                // Iterate through pivot (used) vertices
-                for (Vertex pivot_vertex : pivot_vertices) {
-                    // Iterate through options per pivot vertex
-                    for (auto edge : adj[pivot_vertex]) {
-                        // If adding the pivot vertex would not form a cycle (if the edge would not connect the same partition)
-                        if (union_set.find_operation(pivot_vertex) != union_set.find_operation(edge.get_other(pivot_vertex))) {
-                            // If the distance can be improved
-                            if (dist[edge.get_other(pivot_vertex)] > (dist[pivot_vertex] + edge.get_weight())) {
-                                // Then update the dist vector with new dist
-                                dist[edge.get_other(pivot_vertex)] = (dist[pivot_vertex] + edge.get_weight());
-                                Edge new_edge = Edge(pivot_vertex, edge.get_other(pivot_vertex), dist[edge.get_other(pivot_vertex)]);
-                                // Then push it to the queue
-                                pq.push(new_edge);
-
-                            }
-                            // If it cannot be improved
-                            else {
-                                // Update dist vector with old dist + weight
-                                Edge new_edge = Edge(pivot_vertex, edge.get_other(pivot_vertex), edge.get_weight()+dist[pivot_vertex]);
-                                // Then push it to the queue
-                                pq.push(new_edge);
-                            }
-                        }
-                    }
-                }
-                // Take top value of queue, then that is the turn, so update prev and add the vertex that has not been used to the used pivot_vertices
-                if (pq.empty()) { return std::tuple(dist, prev); }
-                Edge best = pq.top(); pq.pop();
-                Vertex first_vertex, second_vertex, old_vertex, new_vertex;
-                first_vertex = best.get_left(); second_vertex = best.get_right();
-                bool in_first = in(first_vertex, pivot_vertices);
-                bool in_second = in(second_vertex, pivot_vertices);
-                // If connecting two disjoint trees in an edge with two used vertices
-                if (in_first and in_second) {
-                    // Decide which edge comes first in prev
-                    if (union_set.find_operation(first_vertex) == v) {
-                        old_vertex = first_vertex;
-                        new_vertex = second_vertex;
-                    }
-                    else if (union_set.find_operation(second_vertex) == v) {
-                        old_vertex = second_vertex;
-                        new_vertex = first_vertex;
-                    }
-                }
-                // If our used vertex is the first vertex in the best edge
-                else if (in_first and !in_second) {
-                    old_vertex = first_vertex;
-                    new_vertex = second_vertex;
-                }
-                else if (!in_first and in_second) {
-                    old_vertex = second_vertex;
-                    new_vertex = first_vertex;
-                }
+        // Whether any path joins v and u; read-only, so safe from several threads once the graph is built
+        bool connected(Vertex v, Vertex u) const {
+            return union_set.connected(v, u);
+        }
 
-                prev[new_vertex] = old_vertex;
-
-                // // Update prev
-                // if (in(best.either(), pivot_vertices)) {
-                //     old_vertex = best.either();
-                //     new_vertex = best.other(best.either());
-                //     prev[new_vertex] = old_vertex;
-                // }
-                // else if (in(best.other(best.either()), pivot_vertices)) {
-                //     old_vertex =  best.other(best.either());
-                //     new_vertex = best.either();
-                //     prev[new_vertex] = old_vertex;
-                // }
-
-                // Add to the used vertices
-                pivot_vertices.push_back(new_vertex);
-                // Union the rest
-                union_set.union_operation(best.get_left(), best.get_right());
-                // And pop the rest of the edges out
-                while (!pq.empty()) {
-                    pq.pop();
-                    if (pq.size() > 10) return std::tuple(dist, prev);
-                }
-                // and repeat~
+        std::size_t num_vertices() const {
+            return adj.size();
+        }
+
+        // Calls f(neighbor, weight) for every edge incident to v; this is the interface the search engines run over
+        template <typename FUNCTION>
+        void for_each_neighbor(Vertex v, FUNCTION&& f) const {
+            for (const Edge& edge : adj[v]) {
+                f(edge.get_other(v), edge.get_weight());
             }
-            return std::tuple(dist, prev);
+        }
+
+        // Settles each vertex once through an indexed ARITY-ary heap with decrease-key and stops once 'end' is settled.
+        // Pass NO_VERTEX as 'end' for the full one-to-all tree. The query methods are const and keep their state
+        // in locals, so several threads can query one graph at once.
+        // Once done, add lots of heuristics and test. Then add a fancy visual and keep testing.
+        template <unsigned ARITY = 4>
+        std::tuple<std::vector<double>, std::vector<Vertex>> Dijkstra(Vertex v, Vertex end) const {
+            return dijkstra<ARITY>(*this, v, end);
+        }
+
+        // Dijkstra that also returns what the search did; the counters are only filled in when built with
+        // SHORTEST_PATH_STATS (see SearchStats.hpp)
+        template <unsigned ARITY = 4>
+        std::tuple<std::vector<double>, std::vector<Vertex>, SearchStats> TracedDijkstra(Vertex v, Vertex end) const {
+            SearchStats stats;
+            auto [dist, prev] = dijkstra<ARITY>(*this, v, end, stats);
+            return std::tuple(std::move(dist), std::move(prev), stats);
+        }
+
+        // Dijkstra keeping distances as Weights, on a radix heap, Dial's buckets or the 4-ary heap; unreached
+        // vertices get INFINITE_DISTANCE
+        std::tuple<std::vector<Weight>, std::vector<Vertex>> IntegerDijkstra(Vertex v, Vertex end = NO_VERTEX, QueueBackend backend = QueueBackend::RADIX_HEAP) const {
+            return integer_dijkstra(*this, v, end, backend);
+        }
+
+        // Point-to-point query growing searches from both ends; returns the distance and the path from v to end
+        template <unsigned ARITY = 4>
+        std::tuple<double, std::vector<Vertex>> BidirectionalDijkstra(Vertex v, Vertex end) const {
+            return bidirectional_dijkstra<ARITY>(*this, v, end);
+        }
+
+        // Dijkstra guided by a lower-bound estimate of the distance left to 'end' (see AStar.hpp for the heuristics)
+        template <unsigned ARITY = 4, typename HEURISTIC>
+        std::tuple<std::vector<double>, std::vector<Vertex>> AStar(Vertex v, Vertex end, HEURISTIC heuristic) const {
+            return astar<ARITY>(*this, v, end, heuristic);
+        }
+
+        // Parallel one-to-all distances by delta-stepping (delta <= 0 picks one from the weights)
+        std::tuple<std::vector<double>, std::vector<Vertex>> DeltaStepping(Vertex v, double delta = 0, unsigned threads = 0) const {
+            return delta_stepping(*this, v, delta, threads);
         }
         
         
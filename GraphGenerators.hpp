@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "Graph.hpp"
+#include "Coordinate.hpp"
+
+// Seeded synthetic graphs for tests and benchmarks. Every generator returns an edge list (ready for Graph or
+// CSRGraph) and is fully determined by its arguments, so the same seed gives the same graph on every run.
+// Weights are integers of at least 1; the geometric generators can also return vertex coordinates.
+
+// Weight per unit of Euclidean length in the geometric graphs; keeps the rounding error of integer weights small
+constexpr double GENERATOR_LENGTH_SCALE = 1e6;
+
+// rows x cols grid with 4-neighbor edges and uniform weights in [1, max_weight]. Vertex r * cols + c sits at
+// (c, r). A road-like worst case for hierarchies: many equally good paths.
+inline std::vector<Edge> grid_graph(std::size_t rows, std::size_t cols, Weight max_weight, unsigned seed, std::vector<Coordinate>* coordinates = nullptr) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<Weight> weight(1, max_weight);
+    std::vector<Edge> edges;
+    edges.reserve(2 * rows * cols);
+    for (std::size_t r = 0; r < rows; r++) {
+        for (std::size_t c = 0; c < cols; c++) {
+            Vertex v = r * cols + c;
+            if (c + 1 < cols) edges.push_back(Edge(v, v + 1, weight(rng)));
+            if (r + 1 < rows) edges.push_back(Edge(v, v + cols, weight(rng)));
+        }
+    }
+    if (coordinates) {
+        coordinates->resize(rows * cols);
+        for (std::size_t v = 0; v < rows * cols; v++) {
+            (*coordinates)[v] = Coordinate{static_cast<double>(v % cols), static_cast<double>(v / cols)};
+        }
+    }
+    return edges;
+}
+
+// n points uniform in the unit square, joined when closer than the radius that gives the requested average
+// degree; weights are the scaled Euclidean lengths. Points are binned into radius-sized cells so only
+// neighboring cells are compared. Close to a road network in how searches spread.
+inline std::vector<Edge> random_geometric_graph(std::size_t n, double average_degree, unsigned seed, std::vector<Coordinate>* coordinates = nullptr) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unit(0, 1);
+    std::vector<Coordinate> points(n);
+    for (Coordinate& p : points) p = Coordinate{unit(rng), unit(rng)};
+
+    std::vector<Edge> edges;
+    if (n > 1) {
+        double radius = std::sqrt(average_degree / (M_PI * n));
+        // At most about one cell per point, so the cell table stays O(n) even for tiny degrees
+        std::size_t cells = static_cast<std::size_t>(std::min(1 / radius, std::sqrt(static_cast<double>(n))));
+        cells = std::max<std::size_t>(cells, 1);
+        auto cell_of = [&](double x) { return std::min(cells - 1, static_cast<std::size_t>(x * cells)); };
+
+        // Counting sort of the points by cell
+        std::vector<std::size_t> offsets(cells * cells + 1, 0);
+        for (const Coordinate& p : points) offsets[cell_of(p.y) * cells + cell_of(p.x) + 1]++;
+        for (std::size_t i = 0; i < cells * cells; i++) offsets[i + 1] += offsets[i];
+        std::vector<Vertex> order(n);
+        std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (Vertex v = 0; v < n; v++) order[cursor[cell_of(points[v].y) * cells + cell_of(points[v].x)]++] = v;
+
+        edges.reserve(static_cast<std::size_t>(n * average_degree / 2 * 1.1));
+        for (Vertex v = 0; v < n; v++) {
+            std::size_t cx = cell_of(points[v].x), cy = cell_of(points[v].y);
+            for (std::size_t y = cy > 0 ? cy - 1 : 0; y <= std::min(cells - 1, cy + 1); y++) {
+                for (std::size_t x = cx > 0 ? cx - 1 : 0; x <= std::min(cells - 1, cx + 1); x++) {
+                    for (std::size_t i = offsets[y * cells + x]; i < offsets[y * cells + x + 1]; i++) {
+                        Vertex w = order[i];
+                        if (w <= v) continue;
+                        double length = std::hypot(points[v].x - points[w].x, points[v].y - points[w].y);
+                        if (length > radius) continue;
+                        Weight weight = static_cast<Weight>(std::llround(length * GENERATOR_LENGTH_SCALE));
+                        edges.push_back(Edge(v, w, std::max<Weight>(weight, 1)));
+                    }
+                }
+            }
+        }
+    }
+    if (coordinates) *coordinates = std::move(points);
+    return edges;
+}
+
+// G(n, m) Erdős–Rényi graph with m = n * average_degree / 2 uniformly random edges (self loops redrawn,
+// parallel edges possible) and uniform weights in [1, max_weight]. Small diameter: searches explode quickly.
+inline std::vector<Edge> erdos_renyi_graph(std::size_t n, double average_degree, Weight max_weight, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<Edge> edges;
+    if (n < 2) return edges;
+    std::uniform_int_distribution<Vertex> vertex(0, n - 1);
+    std::uniform_int_distribution<Weight> weight(1, max_weight);
+    std::size_t m = static_cast<std::size_t>(n * average_degree / 2);
+    edges.reserve(m);
+    while (edges.size() < m) {
+        Vertex v = vertex(rng), w = vertex(rng);
+        if (v != w) edges.push_back(Edge(v, w, weight(rng)));
+    }
+    return edges;
+}
+
+// A random recursive tree (vertex i hangs off a uniform earlier vertex) plus one uniform extra edge per vertex
+// (self loops and parallel edges possible), weights uniform in [1, max_weight]. Always connected, with about
+// 2n edges and plenty of short cycles: a small general-purpose test graph.
+inline std::vector<Edge> random_tree_graph(std::size_t n, Weight max_weight, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<Edge> edges;
+    if (n < 2) return edges;
+    std::uniform_int_distribution<Weight> weight(1, max_weight);
+    edges.reserve(2 * (n - 1));
+    for (Vertex v = 1; v < n; v++) {
+        edges.push_back(Edge(v, std::uniform_int_distribution<Vertex>(0, v - 1)(rng), weight(rng)));
+        edges.push_back(Edge(v, std::uniform_int_distribution<Vertex>(0, n - 1)(rng), weight(rng)));
+    }
+    return edges;
+}
+
+// Barabási–Albert preferential attachment: every new vertex links to edges_per_vertex earlier vertices picked
+// with probability proportional to their degree, giving a power-law degree distribution with a few huge hubs.
+// Uniform weights in [1, max_weight].
+inline std::vector<Edge> power_law_graph(std::size_t n, std::size_t edges_per_vertex, Weight max_weight, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<Weight> weight(1, max_weight);
+    std::vector<Edge> edges;
+    if (n < 2 or edges_per_vertex == 0) return edges;
+    edges.reserve(n * edges_per_vertex);
+    // Every edge endpoint appears here once, so a uniform pick from it is a degree-proportional pick
+    std::vector<Vertex> endpoints;
+    endpoints.reserve(2 * n * edges_per_vertex);
+    std::size_t seeds = std::min(n, edges_per_vertex + 1);
+    for (Vertex v = 1; v < seeds; v++) {
+        edges.push_back(Edge(v, v - 1, weight(rng)));
+        endpoints.push_back(v);
+        endpoints.push_back(v - 1);
+    }
+    for (Vertex v = seeds; v < n; v++) {
+        for (std::size_t i = 0; i < edges_per_vertex; i++) {
+            Vertex w = endpoints[std::uniform_int_distribution<std::size_t>(0, endpoints.size() - 1)(rng)];
+            edges.push_back(Edge(v, w, weight(rng)));
+            endpoints.push_back(w);
+        }
+        for (std::size_t i = 0; i < edges_per_vertex; i++) endpoints.push_back(v);
+    }
+    return edges;
+}
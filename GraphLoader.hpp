@@ -0,0 +1,192 @@
+#pragma once
+
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Graph.hpp"
+#include "CSRGraph.hpp"
+#include "DirectedGraph.hpp"
+#include "MappedFile.hpp"
+
+// DIMACS shortest path files ("c" comments, one "p sp n m" line, "a u v w" arcs) or plain edge lists with
+// one "u v w" per line separated by commas, semicolons, tabs or spaces. Edge list lines that do not start
+// with a digit (headers, '#' comments) are skipped.
+// Vertex ids are taken as written, so for 1-based DIMACS files vertex 0 is left isolated. Each DIMACS arc
+// becomes an undirected Edge, so files that list both directions of a road produce parallel edges, unless the
+// file is loaded with load_directed_graph, which keeps every line as one arc.
+enum class EdgeListFormat { DIMACS, EDGE_LIST };
+
+struct LoadStats {
+    std::size_t bytes = 0;
+    std::size_t edges = 0;
+    unsigned threads = 0;
+    double parse_seconds = 0;
+    double build_seconds = 0;
+
+    double megabytes_per_second() const {
+        return parse_seconds > 0 ? bytes / parse_seconds / 1e6 : 0;
+    }
+};
+
+// Guesses the format from the file extension: ".gr" is DIMACS, anything else an edge list
+inline EdgeListFormat detect_format(const std::string& path) {
+    std::size_t dot = path.rfind('.');
+    if (dot != std::string::npos and path.compare(dot, std::string::npos, ".gr") == 0) return EdgeListFormat::DIMACS;
+    return EdgeListFormat::EDGE_LIST;
+}
+
+// Parses one byte range of a text graph file. Every read is a pointer bump over the mapped bytes;
+// nothing is copied into strings.
+class EdgeListParser {
+    private:
+        const char* p;
+        const char* end;
+        const char* file_start;
+
+        static bool is_separator(char c) { return c == ' ' or c == '\t' or c == ',' or c == ';' or c == '\r'; }
+        static bool is_digit(char c) { return c >= '0' and c <= '9'; }
+
+        void skip_separators() {
+            while (p < end and is_separator(*p)) p++;
+        }
+
+        void skip_line() {
+            while (p < end and *p != '\n') p++;
+            if (p < end) p++;
+        }
+
+        [[noreturn]] void fail(const char* what) {
+            throw std::runtime_error(std::string(what) + " at byte " + std::to_string(p - file_start));
+        }
+
+        unsigned long read_unsigned() {
+            skip_separators();
+            if (p >= end or !is_digit(*p)) fail("Expected an unsigned integer");
+            unsigned long x = 0;
+            while (p < end and is_digit(*p)) {
+                if (__builtin_mul_overflow(x, 10ul, &x) or __builtin_add_overflow(x, static_cast<unsigned long>(*p - '0'), &x)) {
+                    fail("Integer too large");
+                }
+                p++;
+            }
+            return x;
+        }
+
+    public:
+        EdgeListParser(const char* begin, const char* end, const char* file_start) : p(begin), end(end), file_start(file_start) {}
+
+        // EDGE is Edge or DirectedEdge, built from {u, v, w}
+        template <typename EDGE>
+        void parse(EdgeListFormat format, std::vector<EDGE>& out) {
+            while (p < end) {
+                skip_separators();
+                if (p >= end) break;
+                char c = *p;
+                if (format == EdgeListFormat::DIMACS) {
+                    if (c != 'a') {
+                        skip_line();
+                        continue;
+                    }
+                    p++;
+                }
+                else if (!is_digit(c)) {
+                    skip_line();
+                    continue;
+                }
+                Vertex u = read_unsigned();
+                Vertex v = read_unsigned();
+                Weight w = read_unsigned();
+                out.push_back(EDGE{u, v, w});
+                skip_line();
+            }
+        }
+};
+
+// Splits the mapped text into one chunk per thread, cutting only at line starts, and parses the chunks
+// concurrently. Each thread fills its own vector, so the result is one batch of edges per chunk in file order.
+// Chunks are kept to at least min_chunk bytes, below which starting a thread costs more than it saves.
+template <typename EDGE = Edge>
+std::vector<std::vector<EDGE>> parse_edge_chunks(const char* data, std::size_t size, EdgeListFormat format, unsigned threads,
+                                                 std::size_t min_chunk = 1 << 20) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (min_chunk == 0) min_chunk = 1;
+    if (size / threads < min_chunk) threads = static_cast<unsigned>(size / min_chunk) + 1;
+
+    std::vector<const char*> bounds(threads + 1);
+    bounds[0] = data;
+    bounds[threads] = data + size;
+    for (unsigned i = 1; i < threads; i++) {
+        const char* cut = data + size / threads * i;
+        if (cut < bounds[i - 1]) cut = bounds[i - 1];
+        while (cut > data and cut < data + size and cut[-1] != '\n') cut++;
+        bounds[i] = cut;
+    }
+
+    std::vector<std::vector<EDGE>> chunks(threads);
+    std::vector<std::exception_ptr> errors(threads);
+    auto work = [&](unsigned i) {
+        try {
+            // A text edge line is rarely shorter than ~12 bytes, so this usually avoids any regrowth
+            chunks[i].reserve((bounds[i + 1] - bounds[i]) / 12 + 1);
+            EdgeListParser(bounds[i], bounds[i + 1], data).parse(format, chunks[i]);
+        }
+        catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; i++) workers.emplace_back(work, i);
+    work(0);
+    for (std::thread& worker : workers) worker.join();
+    for (std::exception_ptr& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    return chunks;
+}
+
+template <typename EDGE = Edge>
+std::vector<std::vector<EDGE>> load_edge_chunks(const std::string& path, EdgeListFormat format, LoadStats* stats, unsigned threads) {
+    MappedFile file(path);
+    file.advise_sequential();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<EDGE>> chunks = parse_edge_chunks<EDGE>(file.data(), file.size(), format, threads);
+    if (stats != nullptr) {
+        stats->bytes = file.size();
+        stats->threads = static_cast<unsigned>(chunks.size());
+        stats->edges = 0;
+        for (const std::vector<EDGE>& chunk : chunks) stats->edges += chunk.size();
+        stats->parse_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return chunks;
+}
+
+// Loads a text graph file into a Graph with its two-pass bulk build
+inline Graph load_graph(const std::string& path, EdgeListFormat format, LoadStats* stats = nullptr, unsigned threads = 0) {
+    std::vector<std::vector<Edge>> chunks = load_edge_chunks(path, format, stats, threads);
+    auto start = std::chrono::steady_clock::now();
+    Graph G(chunks);
+    if (stats != nullptr) stats->build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return G;
+}
+
+// Loads a text graph file straight into the packed CSR layout, skipping the per-vertex Edge lists entirely
+inline CSRGraph load_csr_graph(const std::string& path, EdgeListFormat format, LoadStats* stats = nullptr, unsigned threads = 0) {
+    std::vector<std::vector<Edge>> chunks = load_edge_chunks(path, format, stats, threads);
+    auto start = std::chrono::steady_clock::now();
+    CSRGraph G(chunks);
+    if (stats != nullptr) stats->build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return G;
+}
+
+// Loads a text graph file as a directed graph: each line is one arc u -> v, as DIMACS means it
+inline DirectedGraph load_directed_graph(const std::string& path, EdgeListFormat format, LoadStats* stats = nullptr, unsigned threads = 0) {
+    std::vector<std::vector<DirectedEdge>> chunks = load_edge_chunks<DirectedEdge>(path, format, stats, threads);
+    auto start = std::chrono::steady_clock::now();
+    DirectedGraph G(chunks);
+    if (stats != nullptr) stats->build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return G;
+}
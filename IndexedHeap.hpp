@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+
+using Vertex = unsigned long;
+
+// A d-ary min-heap over vertex ids with a position index, so a queued vertex can have its key
+// lowered in place instead of being pushed again. ARITY is a compile-time constant so the
+// parent/child arithmetic folds into shifts for powers of two.
+template <typename KEY, unsigned ARITY = 4>
+class IndexedHeap {
+    static_assert(ARITY >= 2, "IndexedHeap needs an arity of at least 2");
+    private:
+        struct Node {
+            KEY key;
+            Vertex vertex;
+        };
+
+        static constexpr std::size_t NOT_IN_HEAP = static_cast<std::size_t>(-1);
+
+        std::vector<Node> heap;
+        std::vector<std::size_t> position;  // position[v] is v's slot in heap, or NOT_IN_HEAP
+
+        void place(std::size_t i, const Node& node) {
+            heap[i] = node;
+            position[node.vertex] = i;
+        }
+
+        void sift_up(std::size_t i) {
+            Node node = heap[i];
+            while (i > 0) {
+                std::size_t parent = (i - 1) / ARITY;
+                if (!(node.key < heap[parent].key)) break;
+                place(i, heap[parent]);
+                i = parent;
+            }
+            place(i, node);
+        }
+
+        void sift_down(std::size_t i) {
+            Node node = heap[i];
+            std::size_t n = heap.size();
+            while (true) {
+                std::size_t first = i * ARITY + 1;
+                if (first >= n) break;
+                std::size_t last = first + ARITY < n ? first + ARITY : n;
+                std::size_t best = first;
+                for (std::size_t c = first + 1; c < last; c++) {
+                    if (heap[c].key < heap[best].key) best = c;
+                }
+                if (!(heap[best].key < node.key)) break;
+                place(i, heap[best]);
+                i = best;
+            }
+            place(i, node);
+        }
+
+    public:
+        IndexedHeap() {}
+        IndexedHeap(std::size_t num_vertices) : position(num_vertices, NOT_IN_HEAP) {}
+
+        // Grows the index so vertices up to num_vertices-1 can be queued
+        void resize(std::size_t num_vertices) {
+            if (num_vertices > position.size()) position.resize(num_vertices, NOT_IN_HEAP);
+        }
+
+        bool empty() const { return heap.empty(); }
+        std::size_t size() const { return heap.size(); }
+        bool contains(Vertex v) const { return v < position.size() and position[v] != NOT_IN_HEAP; }
+
+        KEY get_key(Vertex v) const { return heap[position[v]].key; }
+        Vertex top() const { return heap.front().vertex; }
+        KEY top_key() const { return heap.front().key; }
+
+        void push(Vertex v, KEY key) {
+            if (contains(v)) { throw std::runtime_error("Vertex is already in the heap"); }
+            heap.push_back(Node{key, v});
+            position[v] = heap.size() - 1;
+            sift_up(heap.size() - 1);
+        }
+
+        void decrease_key(Vertex v, KEY key) {
+            std::size_t i = position[v];
+            heap[i].key = key;
+            sift_up(i);
+        }
+
+        // Inserts v or lowers its key; returns false if v was queued with a key that is already no larger
+        bool push_or_decrease(Vertex v, KEY key) {
+            if (!contains(v)) {
+                push(v, key);
+                return true;
+            }
+            if (!(key < get_key(v))) return false;
+            decrease_key(v, key);
+            return true;
+        }
+
+        Vertex pop() {
+            if (heap.empty()) { throw std::runtime_error("Cannot pop from an empty heap"); }
+            Vertex v = heap.front().vertex;
+            position[v] = NOT_IN_HEAP;
+            Node last = heap.back();
+            heap.pop_back();
+            if (!heap.empty()) {
+                place(0, last);
+                sift_down(0);
+            }
+            return v;
+        }
+
+        // Only touches the vertices still queued, so a heap can be reused across searches cheaply
+        void clear() {
+            for (const Node& node : heap) position[node.vertex] = NOT_IN_HEAP;
+            heap.clear();
+        }
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+#include "Dijkstra.hpp"
+#include "RadixHeap.hpp"
+#include "BucketQueue.hpp"
+
+// Unreachable; also what a distance that would not fit into a Weight saturates to
+constexpr Weight INFINITE_DISTANCE = std::numeric_limits<Weight>::max();
+
+// Priority queues for integer_dijkstra: the indexed 4-ary heap, a radix heap, or Dial's buckets (for small
+// weights only, see BucketQueue.hpp)
+enum class QueueBackend { HEAP, RADIX_HEAP, DIAL };
+
+template <typename GRAPH>
+Weight max_weight(const GRAPH& G) {
+    Weight largest = 0;
+    for (Vertex u = 0; u < G.num_vertices(); u++) {
+        G.for_each_neighbor(u, [&](Vertex, Weight weight) {
+            if (weight > largest) largest = weight;
+        });
+    }
+    return largest;
+}
+
+// Dijkstra on integer distances from end to end: the same label-setting search as dijkstra(), but the
+// labels stay Weights, so the queue can be a monotone integer queue and no distance is rounded. QUEUE is
+// IndexedHeap<Weight, ARITY>, RadixHeap or BucketQueue; it is left empty, so one queue serves any number of
+// searches. Unreached vertices and paths longer than a Weight can hold get INFINITE_DISTANCE.
+template <typename QUEUE, typename GRAPH>
+std::tuple<std::vector<Weight>, std::vector<Vertex>> integer_dijkstra(const GRAPH& G, Vertex v, Vertex end, QUEUE& pq, SearchStats& stats) {
+    std::size_t n = G.num_vertices();
+    std::vector<Weight> dist;
+    std::vector<Vertex> prev;
+    {
+        ScopedTimer timer(stats.setup_seconds);
+        dist.assign(n, INFINITE_DISTANCE);
+        prev.assign(n, NO_VERTEX);
+        pq.resize(n);
+    }
+    if (v >= n) { return std::tuple(dist, prev); }
+
+    ScopedTimer timer(stats.search_seconds);
+    dist[v] = 0;
+    prev[v] = v;
+    pq.push(v, 0);
+    stats_count(stats.pushes);
+    while (!pq.empty()) {
+        Vertex u = pq.pop();
+        stats_count(stats.pops);
+        stats_count(stats.settled);
+        if (u == end) break;
+        Weight du = dist[u];
+        G.for_each_neighbor(u, [&](Vertex w, Weight weight) {
+            stats_count(stats.relaxations);
+            // du + weight would overflow (or reach the infinity marker): treat as no path
+            if (weight >= INFINITE_DISTANCE - du) return;
+            Weight candidate = du + weight;
+            if (candidate < dist[w]) {
+                dist[w] = candidate;
+                prev[w] = u;
+                stats_count_push(stats, pq, w);
+                pq.push_or_decrease(w, candidate);
+            }
+        });
+    }
+    pq.clear();
+    return std::tuple(dist, prev);
+}
+
+template <typename GRAPH>
+std::tuple<std::vector<Weight>, std::vector<Vertex>> integer_dijkstra(const GRAPH& G, Vertex v, Vertex end, QueueBackend backend, SearchStats& stats) {
+    if (backend == QueueBackend::HEAP) {
+        IndexedHeap<Weight, 4> pq(G.num_vertices());
+        return integer_dijkstra(G, v, end, pq, stats);
+    }
+    if (backend == QueueBackend::RADIX_HEAP) {
+        RadixHeap pq(G.num_vertices());
+        return integer_dijkstra(G, v, end, pq, stats);
+    }
+    if (backend == QueueBackend::DIAL) {
+        BucketQueue pq(G.num_vertices(), max_weight(G));
+        return integer_dijkstra(G, v, end, pq, stats);
+    }
+    throw std::runtime_error("Unknown queue backend");
+}
+
+template <typename GRAPH>
+std::tuple<std::vector<Weight>, std::vector<Vertex>> integer_dijkstra(const GRAPH& G, Vertex v, Vertex end = NO_VERTEX,
+                                                                      QueueBackend backend = QueueBackend::RADIX_HEAP) {
+    SearchStats stats;
+    return integer_dijkstra(G, v, end, backend, stats);
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Dijkstra.hpp"
+#include "BidirectionalDijkstra.hpp"
+
+enum class LandmarkSelection { FARTHEST, AVOID };
+
+// ALT preprocessing: exact distances from k landmarks to every vertex. By the triangle inequality
+// |d(L, t) - d(L, v)| is a lower bound on d(v, t) for every landmark L, which is what the A* landmark
+// heuristic uses. Distances are stored as 32-bit integers in vertex-major order so the k values for one
+// vertex share a cache line; values too large to store are clamped, which keeps the bounds admissible.
+class Landmarks {
+    private:
+        static constexpr std::uint32_t UNREACHABLE = std::numeric_limits<std::uint32_t>::max();
+        static constexpr char MAGIC[8] = {'S', 'P', 'L', 'A', 'N', 'D', 'M', 'K'};
+        static constexpr std::uint32_t VERSION = 1;
+
+        std::size_t n = 0;
+        std::size_t stride = 0;  // landmarks requested, the row length while the table is being filled
+        std::vector<Vertex> landmarks;
+        std::vector<std::uint32_t> distances;  // distances[v * k + i] = d(landmarks[i], v)
+
+        static std::uint32_t pack(double d) {
+            if (d == 1.0 / 0.0) return UNREACHABLE;
+            if (d >= UNREACHABLE - 1.0) return UNREACHABLE - 1;
+            return static_cast<std::uint32_t>(d);
+        }
+
+        template <typename GRAPH>
+        std::vector<double> add_landmark(const GRAPH& G, Vertex landmark) {
+            std::vector<double> dist = std::get<0>(dijkstra(G, landmark, NO_VERTEX));
+            std::size_t i = landmarks.size();
+            landmarks.push_back(landmark);
+            for (Vertex v = 0; v < n; v++) {
+                distances[v * stride + i] = pack(dist[v]);
+            }
+            return dist;
+        }
+
+        // Farthest-point: each new landmark is the vertex farthest from all landmarks chosen so far,
+        // with unreachable vertices counting as farthest so every component gets covered.
+        template <typename GRAPH>
+        void select_farthest(const GRAPH& G, std::size_t count, std::mt19937& rng) {
+            std::vector<double> nearest = std::get<0>(dijkstra(G, rng() % n, NO_VERTEX));
+            while (landmarks.size() < count) {
+                Vertex farthest = 0;
+                for (Vertex v = 1; v < n; v++) {
+                    if (nearest[v] > nearest[farthest]) farthest = v;
+                }
+                if (!landmarks.empty() and nearest[farthest] == 0) break;  // fewer vertices than landmarks
+                std::vector<double> dist = add_landmark(G, farthest);
+                if (landmarks.size() == 1) nearest = dist;
+                for (Vertex v = 0; v < n; v++) {
+                    if (dist[v] < nearest[v]) nearest[v] = dist[v];
+                }
+            }
+        }
+
+        // Avoid (Goldberg & Werneck): grow a shortest path tree from a random root, weight each vertex by how
+        // badly the current landmarks bound its root distance, and descend into the heaviest landmark-free
+        // subtree; the leaf reached becomes the next landmark.
+        template <typename GRAPH>
+        void select_avoid(const GRAPH& G, std::size_t count, std::mt19937& rng) {
+            select_farthest(G, 1, rng);
+            while (landmarks.size() < count) {
+                std::size_t chosen = landmarks.size();
+                Vertex root = rng() % n;
+                auto [dist, prev] = dijkstra(G, root, NO_VERTEX);
+
+                std::vector<Vertex> order;
+                for (Vertex v = 0; v < n; v++) {
+                    if (dist[v] != 1.0 / 0.0) order.push_back(v);
+                }
+                std::sort(order.begin(), order.end(), [&](Vertex a, Vertex b) { return dist[a] > dist[b]; });
+
+                std::vector<double> size(n, 0);
+                std::vector<bool> has_landmark(n, false);
+                for (std::size_t i = 0; i < chosen; i++) has_landmark[landmarks[i]] = true;
+                for (Vertex v : order) {
+                    double bound = 0;
+                    for (std::size_t i = 0; i < chosen; i++) {
+                        std::uint32_t a = distances[root * stride + i], b = distances[v * stride + i];
+                        if (a == UNREACHABLE or b == UNREACHABLE) continue;
+                        double gap = a > b ? double(a - b) : double(b - a);
+                        if (gap > bound) bound = gap;
+                    }
+                    size[v] += dist[v] - bound;
+                    if (has_landmark[v]) size[v] = 0;
+                    if (v != root) {
+                        Vertex parent = prev[v];
+                        if (has_landmark[v]) has_landmark[parent] = true;
+                        size[parent] += size[v];
+                    }
+                }
+
+                std::vector<std::vector<Vertex>> children(n);
+                for (Vertex v : order) {
+                    if (v != root) children[prev[v]].push_back(v);
+                }
+                Vertex at = root;
+                for (Vertex v : order) {
+                    if (size[v] > size[at]) at = v;
+                }
+                if (size[at] <= 0) break;
+                while (true) {
+                    Vertex next = NO_VERTEX;
+                    for (Vertex c : children[at]) {
+                        if (next == NO_VERTEX or size[c] > size[next]) next = c;
+                    }
+                    if (next == NO_VERTEX or size[next] <= 0) break;
+                    at = next;
+                }
+                add_landmark(G, at);
+            }
+        }
+
+    public:
+        Landmarks() {}
+
+        template <typename GRAPH>
+        Landmarks(const GRAPH& G, std::size_t k, LandmarkSelection selection = LandmarkSelection::FARTHEST, unsigned seed = 1)
+            : n(G.num_vertices()), stride(k) {
+            static_assert(!has_in_neighbors<GRAPH>::value, "Landmarks needs an undirected graph");
+            if (n == 0 or k == 0) return;
+            distances.assign(n * k, UNREACHABLE);
+            std::mt19937 rng(seed);
+            if (selection == LandmarkSelection::FARTHEST) select_farthest(G, k, rng);
+            else select_avoid(G, k, rng);
+            if (landmarks.size() < k) {
+                // Fewer useful landmarks than asked for: repack the table to the number actually chosen
+                std::vector<std::uint32_t> packed(n * landmarks.size());
+                for (Vertex v = 0; v < n; v++) {
+                    for (std::size_t i = 0; i < landmarks.size(); i++) packed[v * landmarks.size() + i] = distances[v * k + i];
+                }
+                distances.swap(packed);
+            }
+        }
+
+        std::size_t num_vertices() const { return n; }
+        std::size_t size() const { return landmarks.size(); }
+        const std::vector<Vertex>& get_landmarks() const { return landmarks; }
+        const std::uint32_t* row(Vertex v) const { return distances.data() + v * landmarks.size(); }
+
+        // Largest triangle-inequality bound on d(v, t) over all landmarks that reach both
+        double lower_bound(Vertex v, Vertex t) const {
+            std::size_t k = landmarks.size();
+            const std::uint32_t* a = row(v);
+            const std::uint32_t* b = row(t);
+            std::uint32_t best = 0;
+            for (std::size_t i = 0; i < k; i++) {
+                if (a[i] == UNREACHABLE or b[i] == UNREACHABLE) continue;
+                std::uint32_t gap = a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+                if (gap > best) best = gap;
+            }
+            return best;
+        }
+
+        void save(const std::string& path) const {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            if (!out) { throw std::runtime_error("Cannot open " + path + " for writing"); }
+            std::uint64_t header[2] = {n, landmarks.size()};
+            out.write(MAGIC, sizeof(MAGIC));
+            out.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+            out.write(reinterpret_cast<const char*>(header), sizeof(header));
+            for (Vertex landmark : landmarks) {
+                std::uint64_t id = landmark;
+                out.write(reinterpret_cast<const char*>(&id), sizeof(id));
+            }
+            out.write(reinterpret_cast<const char*>(distances.data()), distances.size() * sizeof(std::uint32_t));
+            if (!out) { throw std::runtime_error("Failed writing " + path); }
+        }
+
+        static Landmarks load(const std::string& path) {
+            std::ifstream in(path, std::ios::binary);
+            if (!in) { throw std::runtime_error("Cannot open " + path); }
+            char magic[8];
+            std::uint32_t version = 0;
+            std::uint64_t header[2];
+            in.read(magic, sizeof(magic));
+            in.read(reinterpret_cast<char*>(&version), sizeof(version));
+            in.read(reinterpret_cast<char*>(header), sizeof(header));
+            if (!in or std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 or version != VERSION) {
+                throw std::runtime_error(path + " is not a landmark file");
+            }
+            Landmarks L;
+            L.n = header[0];
+            L.landmarks.resize(header[1]);
+            for (Vertex& landmark : L.landmarks) {
+                std::uint64_t id;
+                in.read(reinterpret_cast<char*>(&id), sizeof(id));
+                landmark = id;
+            }
+            L.distances.resize(L.n * L.landmarks.size());
+            in.read(reinterpret_cast<char*>(L.distances.data()), L.distances.size() * sizeof(std::uint32_t));
+            if (!in) { throw std::runtime_error(path + " is truncated"); }
+            return L;
+        }
+};
+
+// Where the landmark table for a graph file is kept by convention
+inline std::string landmark_path(const std::string& graph_path) {
+    return graph_path + ".landmarks";
+}
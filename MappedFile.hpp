@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Owns a read-only memory mapping of a whole file. Moving it keeps the mapping at the same address.
+class MappedFile {
+    private:
+        void* base = nullptr;
+        std::size_t length = 0;
+
+        void release() {
+            if (base != nullptr) { munmap(base, length); }
+            base = nullptr;
+            length = 0;
+        }
+
+    public:
+        MappedFile() {}
+
+        // With prefault set the whole file is read in up front (MAP_POPULATE) instead of on first touch
+        MappedFile(const std::string& path, bool prefault = false) {
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) { throw std::runtime_error("Cannot open " + path); }
+            struct stat info;
+            if (fstat(fd, &info) != 0) {
+                close(fd);
+                throw std::runtime_error("Cannot stat " + path);
+            }
+            length = info.st_size;
+            if (length == 0) {
+                close(fd);
+                return;
+            }
+            base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE | (prefault ? MAP_POPULATE : 0), fd, 0);
+            close(fd);
+            if (base == MAP_FAILED) {
+                base = nullptr;
+                length = 0;
+                throw std::runtime_error("Cannot map " + path);
+            }
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            if (this != &other) {
+                release();
+                std::swap(base, other.base);
+                std::swap(length, other.length);
+            }
+            return *this;
+        }
+        ~MappedFile() { release(); }
+
+        const char* data() const { return static_cast<const char*>(base); }
+        std::size_t size() const { return length; }
+
+        // Hints the kernel to read ahead aggressively, for one front-to-back pass such as parsing
+        void advise_sequential() const {
+            if (base != nullptr) { madvise(base, length, MADV_SEQUENTIAL); }
+        }
+};
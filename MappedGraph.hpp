@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "CSRGraph.hpp"
+#include "MappedFile.hpp"
+#include "Coordinate.hpp"
+
+// On-disk layout of a packed graph (all integers little-endian, every section 64-byte aligned):
+//   GraphFileHeader
+//   offsets      uint64_t[num_vertices + 1]
+//   targets      uint32_t[num_slots]
+//   weights      uint32_t[num_slots]
+//   coordinates  Coordinate[num_vertices]   (only if flags & GRAPH_FILE_HAS_COORDINATES)
+// The section offsets in the header are byte positions from the start of the file, so a reader only has to
+// map the file and add them to the base pointer.
+constexpr char GRAPH_FILE_MAGIC[8] = {'S', 'P', 'G', 'R', 'A', 'P', 'H', '\0'};
+constexpr std::uint32_t GRAPH_FILE_VERSION = 1;
+constexpr std::uint32_t GRAPH_FILE_BYTE_ORDER = 0x01020304;
+constexpr std::uint32_t GRAPH_FILE_HAS_COORDINATES = 1;
+constexpr std::uint64_t GRAPH_FILE_ALIGNMENT = 64;
+
+struct GraphFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+    std::uint64_t num_vertices;
+    std::uint64_t num_slots;
+    std::uint64_t offsets_offset;
+    std::uint64_t targets_offset;
+    std::uint64_t weights_offset;
+    std::uint64_t coordinates_offset;
+    std::uint64_t file_size;
+};
+
+inline std::uint64_t align_up(std::uint64_t x, std::uint64_t alignment) {
+    return (x + alignment - 1) / alignment * alignment;
+}
+
+// Whether count elements of element_size bytes starting at byte offset lie inside a file of file_size bytes
+// behind a header of header_size bytes, at the format's alignment. Never overflows, whatever the header says.
+inline bool file_section_fits(std::uint64_t offset, std::uint64_t count, std::uint64_t element_size, std::uint64_t header_size, std::uint64_t file_size) {
+    return offset % GRAPH_FILE_ALIGNMENT == 0 and offset >= header_size and offset <= file_size and
+           count <= (file_size - offset) / element_size;
+}
+
+// Writes G (and optionally one coordinate per vertex) in the packed graph file format
+inline void write_graph_file(const std::string& path, const CSRGraph& G, const std::vector<Coordinate>* coordinates = nullptr) {
+    if (coordinates != nullptr and coordinates->size() != G.num_vertices()) {
+        throw std::runtime_error("Need exactly one coordinate per vertex");
+    }
+    GraphFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic));
+    header.version = GRAPH_FILE_VERSION;
+    header.byte_order = GRAPH_FILE_BYTE_ORDER;
+    header.flags = coordinates != nullptr ? GRAPH_FILE_HAS_COORDINATES : 0;
+    header.num_vertices = G.num_vertices();
+    header.num_slots = G.num_slots();
+    header.offsets_offset = align_up(sizeof(GraphFileHeader), GRAPH_FILE_ALIGNMENT);
+    header.targets_offset = align_up(header.offsets_offset + (header.num_vertices + 1) * sizeof(std::uint64_t), GRAPH_FILE_ALIGNMENT);
+    header.weights_offset = align_up(header.targets_offset + header.num_slots * sizeof(std::uint32_t), GRAPH_FILE_ALIGNMENT);
+    std::uint64_t end = header.weights_offset + header.num_slots * sizeof(std::uint32_t);
+    if (coordinates != nullptr) {
+        header.coordinates_offset = align_up(end, GRAPH_FILE_ALIGNMENT);
+        end = header.coordinates_offset + header.num_vertices * sizeof(Coordinate);
+    }
+    header.file_size = end;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) { throw std::runtime_error("Cannot open " + path + " for writing"); }
+    std::uint64_t written = 0;
+    auto write_at = [&](std::uint64_t position, const void* data, std::uint64_t bytes) {
+        static const char zeros[GRAPH_FILE_ALIGNMENT] = {};
+        while (written < position) {
+            std::uint64_t pad = position - written < GRAPH_FILE_ALIGNMENT ? position - written : GRAPH_FILE_ALIGNMENT;
+            out.write(zeros, pad);
+            written += pad;
+        }
+        out.write(static_cast<const char*>(data), bytes);
+        written += bytes;
+    };
+    write_at(0, &header, sizeof(header));
+    write_at(header.offsets_offset, G.get_offsets().data(), (header.num_vertices + 1) * sizeof(std::uint64_t));
+    write_at(header.targets_offset, G.get_targets().data(), header.num_slots * sizeof(std::uint32_t));
+    write_at(header.weights_offset, G.get_weights().data(), header.num_slots * sizeof(std::uint32_t));
+    if (coordinates != nullptr) {
+        write_at(header.coordinates_offset, coordinates->data(), header.num_vertices * sizeof(Coordinate));
+    }
+    if (!out) { throw std::runtime_error("Failed writing " + path); }
+}
+
+inline void write_graph_file(const std::string& path, Graph& G, const std::vector<Coordinate>* coordinates = nullptr) {
+    write_graph_file(path, CSRGraph(G), coordinates);
+}
+
+// A read-only graph that queries a packed graph file in place. Opening it maps the file and checks the header:
+// every section must lie inside the file and the offsets must end at num_slots. Nothing is parsed or copied,
+// so the cost of a cold start is the page faults the first queries take; the rows themselves (monotone
+// offsets, target ids) are trusted, since checking them would read the whole file.
+class MappedGraph {
+    private:
+        MappedFile file;
+        const GraphFileHeader* header = nullptr;
+        const std::uint64_t* offsets = nullptr;
+        const std::uint32_t* targets = nullptr;
+        const std::uint32_t* weights = nullptr;
+        const Coordinate* coordinates = nullptr;
+
+    public:
+        MappedGraph(const std::string& path, bool prefault = false) : file(path, prefault) {
+            if (file.size() < sizeof(GraphFileHeader)) {
+                throw std::runtime_error(path + " is too small to be a graph file");
+            }
+            const char* bytes = file.data();
+            header = reinterpret_cast<const GraphFileHeader*>(bytes);
+            if (std::memcmp(header->magic, GRAPH_FILE_MAGIC, sizeof(header->magic)) != 0) {
+                throw std::runtime_error(path + " is not a graph file");
+            }
+            if (header->version != GRAPH_FILE_VERSION or header->byte_order != GRAPH_FILE_BYTE_ORDER) {
+                throw std::runtime_error(path + " has an unsupported version or byte order");
+            }
+            if (header->file_size != file.size()) {
+                throw std::runtime_error(path + " is truncated");
+            }
+            std::uint64_t size = file.size(), n = header->num_vertices, m = header->num_slots;
+            bool fits = n < std::numeric_limits<std::uint64_t>::max() and
+                        file_section_fits(header->offsets_offset, n + 1, sizeof(std::uint64_t), sizeof(GraphFileHeader), size) and
+                        file_section_fits(header->targets_offset, m, sizeof(std::uint32_t), sizeof(GraphFileHeader), size) and
+                        file_section_fits(header->weights_offset, m, sizeof(std::uint32_t), sizeof(GraphFileHeader), size);
+            if (fits and (header->flags & GRAPH_FILE_HAS_COORDINATES)) {
+                fits = file_section_fits(header->coordinates_offset, n, sizeof(Coordinate), sizeof(GraphFileHeader), size);
+            }
+            if (!fits) {
+                throw std::runtime_error(path + " has a section outside the file");
+            }
+            offsets = reinterpret_cast<const std::uint64_t*>(bytes + header->offsets_offset);
+            targets = reinterpret_cast<const std::uint32_t*>(bytes + header->targets_offset);
+            weights = reinterpret_cast<const std::uint32_t*>(bytes + header->weights_offset);
+            if (offsets[0] != 0 or offsets[n] != m) {
+                throw std::runtime_error(path + " has offsets that do not match its slot count");
+            }
+            if (header->flags & GRAPH_FILE_HAS_COORDINATES) {
+                coordinates = reinterpret_cast<const Coordinate*>(bytes + header->coordinates_offset);
+            }
+        }
+
+        std::size_t num_vertices() const { return header->num_vertices; }
+        std::size_t num_slots() const { return header->num_slots; }
+        std::size_t degree(Vertex v) const { return offsets[v + 1] - offsets[v]; }
+
+        template <typename FUNCTION>
+        void for_each_neighbor(Vertex v, FUNCTION&& f) const {
+            std::uint64_t end = offsets[v + 1];
+            for (std::uint64_t i = offsets[v]; i < end; i++) {
+                f(static_cast<Vertex>(targets[i]), static_cast<Weight>(weights[i]));
+            }
+        }
+
+        PackedRow row(Vertex v) const { return PackedRow{targets + offsets[v], weights + offsets[v], degree(v)}; }
+
+        bool has_coordinates() const { return coordinates != nullptr; }
+        const Coordinate& get_coordinate(Vertex v) const { return coordinates[v]; }
+
+        template <unsigned ARITY = 4>
+        std::tuple<std::vector<double>, std::vector<Vertex>> Dijkstra(Vertex v, Vertex end) const {
+            return dijkstra<ARITY>(*this, v, end);
+        }
+
+        std::tuple<std::vector<double>, std::vector<Vertex>> SimdDijkstra(Vertex v, Vertex end = NO_VERTEX) const {
+            return simd_dijkstra(*this, v, end);
+        }
+};
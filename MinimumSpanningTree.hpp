@@ -0,0 +1,216 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "Graph.hpp"
+#include "ThreadPool.hpp"
+#include "UnionFind.hpp"
+
+// A minimum spanning forest: one minimum spanning tree per connected component
+struct SpanningForest {
+    std::vector<Edge> edges;
+    Weight total_weight = 0;
+    std::size_t components = 0;  // trees, isolated vertices included: num_vertices - edges.size()
+};
+
+enum class SpanningForestMethod { KRUSKAL, FILTER_KRUSKAL, BORUVKA };
+
+inline const char* spanning_forest_method_name(SpanningForestMethod method) {
+    if (method == SpanningForestMethod::KRUSKAL) return "kruskal";
+    if (method == SpanningForestMethod::FILTER_KRUSKAL) return "filter_kruskal";
+    return "boruvka";
+}
+
+inline bool lighter(const Edge& a, const Edge& b) { return a.get_weight() < b.get_weight(); }
+
+// Sorts by weight on the pool: one run per thread sorted in parallel, then pairs of runs merged in parallel
+// rounds between two buffers
+inline void parallel_sort_by_weight(std::vector<Edge>& edges, ThreadPool& pool) {
+    std::size_t m = edges.size(), runs = pool.size();
+    if (runs == 1 or m < 1 << 16) {
+        std::sort(edges.begin(), edges.end(), lighter);
+        return;
+    }
+    std::vector<std::size_t> bounds(runs + 1);
+    for (std::size_t r = 0; r <= runs; r++) bounds[r] = m * r / runs;
+    pool.parallel_for(0, runs, [&](std::size_t r, unsigned) {
+        std::sort(edges.begin() + bounds[r], edges.begin() + bounds[r + 1], lighter);
+    }, 1);
+    std::vector<Edge> buffer(m);
+    std::vector<Edge>* from = &edges;
+    std::vector<Edge>* to = &buffer;
+    for (std::size_t width = 1; width < runs; width *= 2) {
+        pool.parallel_for(0, (runs + 2 * width - 1) / (2 * width), [&](std::size_t pair, unsigned) {
+            std::size_t first = bounds[2 * width * pair];
+            std::size_t middle = bounds[std::min(runs, 2 * width * pair + width)];
+            std::size_t last = bounds[std::min(runs, 2 * width * (pair + 1))];
+            std::merge(from->begin() + first, from->begin() + middle, from->begin() + middle, from->begin() + last, to->begin() + first, lighter);
+        }, 1);
+        std::swap(from, to);
+    }
+    if (from != &edges) edges.swap(buffer);
+}
+
+// The edges of one sorted batch that join two trees, in order, added to the forest
+inline void kruskal_scan(const std::vector<Edge>& sorted, ConcurrentUnionFind& sets, SpanningForest& forest) {
+    for (const Edge& e : sorted) {
+        if (sets.unite(e.get_left(), e.get_right())) {
+            forest.edges.push_back(e);
+            forest.total_weight += e.get_weight();
+        }
+    }
+}
+
+// Kruskal: sort all edges by weight in parallel, then one pass keeping every edge that joins two trees
+inline SpanningForest kruskal(std::vector<Edge> edges, std::size_t num_vertices, ThreadPool& pool) {
+    for (const Edge& e : edges) num_vertices = std::max(num_vertices, e.get_left() + 1);
+    SpanningForest forest;
+    ConcurrentUnionFind sets(num_vertices);
+    parallel_sort_by_weight(edges, pool);
+    kruskal_scan(edges, sets, forest);
+    forest.components = num_vertices - forest.edges.size();
+    return forest;
+}
+
+// Keeps the edges with keep(e) in order, every thread filtering its own block into its own list first
+template <typename KEEP>
+std::vector<Edge> parallel_filter(const std::vector<Edge>& edges, ThreadPool& pool, KEEP&& keep) {
+    std::size_t blocks = pool.size() * 4;
+    std::vector<std::vector<Edge>> kept(blocks);
+    pool.parallel_for(0, blocks, [&](std::size_t b, unsigned) {
+        std::size_t first = edges.size() * b / blocks, last = edges.size() * (b + 1) / blocks;
+        for (std::size_t i = first; i < last; i++) {
+            if (keep(edges[i])) kept[b].push_back(edges[i]);
+        }
+    }, 1);
+    std::size_t total = 0;
+    for (const std::vector<Edge>& list : kept) total += list.size();
+    std::vector<Edge> result;
+    result.reserve(total);
+    for (const std::vector<Edge>& list : kept) result.insert(result.end(), list.begin(), list.end());
+    return result;
+}
+
+// Filter-Kruskal (Osipov, Sanders & Singler): split the edges at a pivot weight, solve the light half first,
+// then drop every heavy edge whose ends the light half already connected before touching the rest. On
+// graphs with many more edges than vertices most heavy edges never get sorted at all. Batches of up to
+// 'base' edges go to plain Kruskal; partitioning and filtering run on the pool.
+inline void filter_kruskal_step(std::vector<Edge> edges, ConcurrentUnionFind& sets, SpanningForest& forest, ThreadPool& pool,
+                                std::size_t base, std::mt19937_64& rng) {
+    if (edges.size() <= base) {
+        parallel_sort_by_weight(edges, pool);
+        kruskal_scan(edges, sets, forest);
+        return;
+    }
+    // Median of a small random sample
+    std::vector<Weight> sample(31);
+    for (Weight& w : sample) w = edges[rng() % edges.size()].get_weight();
+    std::nth_element(sample.begin(), sample.begin() + sample.size() / 2, sample.end());
+    Weight pivot = sample[sample.size() / 2];
+    std::vector<Edge> light = parallel_filter(edges, pool, [&](const Edge& e) { return e.get_weight() <= pivot; });
+    if (light.size() == edges.size()) {
+        // Nothing above the pivot, e.g. all weights equal: no split to be had
+        parallel_sort_by_weight(light, pool);
+        kruskal_scan(light, sets, forest);
+        return;
+    }
+    std::vector<Edge> heavy = parallel_filter(edges, pool, [&](const Edge& e) { return e.get_weight() > pivot; });
+    std::vector<Edge>().swap(edges);
+    filter_kruskal_step(std::move(light), sets, forest, pool, base, rng);
+    heavy = parallel_filter(heavy, pool, [&](const Edge& e) { return !sets.connected(e.get_left(), e.get_right()); });
+    filter_kruskal_step(std::move(heavy), sets, forest, pool, base, rng);
+}
+
+inline SpanningForest filter_kruskal(std::vector<Edge> edges, std::size_t num_vertices, ThreadPool& pool) {
+    for (const Edge& e : edges) num_vertices = std::max(num_vertices, e.get_left() + 1);
+    SpanningForest forest;
+    ConcurrentUnionFind sets(num_vertices);
+    std::mt19937_64 rng(num_vertices);
+    filter_kruskal_step(std::move(edges), sets, forest, pool, std::max<std::size_t>(num_vertices, 1 << 14), rng);
+    forest.components = num_vertices - forest.edges.size();
+    return forest;
+}
+
+// Borůvka: in every round each tree picks its lightest edge to another tree, all picked edges join the
+// forest, and edges inside a tree are dropped, so the number of trees at least halves per round. Every step
+// is parallel: the picks are lock-free minimums per tree root, the joins go through the concurrent
+// union-find, and ties are broken by edge position, so the picked edges can never form a cycle.
+inline SpanningForest boruvka(const std::vector<Edge>& edges, std::size_t num_vertices, ThreadPool& pool) {
+    for (const Edge& e : edges) num_vertices = std::max(num_vertices, e.get_left() + 1);
+    constexpr std::uint64_t NONE = static_cast<std::uint64_t>(-1);
+    SpanningForest forest;
+    ConcurrentUnionFind sets(num_vertices);
+    std::vector<std::atomic<std::uint64_t>> best(num_vertices);
+    for (std::atomic<std::uint64_t>& b : best) b.store(NONE, std::memory_order_relaxed);
+    auto before = [&](std::uint64_t a, std::uint64_t b) {
+        return b == NONE or edges[a].get_weight() < edges[b].get_weight() or (edges[a].get_weight() == edges[b].get_weight() and a < b);
+    };
+    auto offer = [&](Vertex root, std::uint64_t i) {
+        std::uint64_t current = best[root].load(std::memory_order_relaxed);
+        while (before(i, current)) {
+            if (best[root].compare_exchange_weak(current, i, std::memory_order_relaxed)) return;
+        }
+    };
+
+    std::vector<std::uint64_t> active(edges.size());
+    for (std::uint64_t i = 0; i < edges.size(); i++) active[i] = i;
+    std::size_t blocks = pool.size() * 4;
+    std::vector<std::vector<std::uint64_t>> kept(blocks);
+    std::vector<std::vector<Edge>> joined(pool.size());
+    std::vector<Vertex> roots;
+    while (!active.empty()) {
+        // Picks, dropping edges that no longer leave their tree
+        pool.parallel_for(0, blocks, [&](std::size_t b, unsigned) {
+            std::size_t first = active.size() * b / blocks, last = active.size() * (b + 1) / blocks;
+            kept[b].clear();
+            for (std::size_t k = first; k < last; k++) {
+                std::uint64_t i = active[k];
+                Vertex rv = sets.find(edges[i].get_left()), ru = sets.find(edges[i].get_right());
+                if (rv == ru) continue;
+                kept[b].push_back(i);
+                offer(rv, i);
+                offer(ru, i);
+            }
+        }, 1);
+        active.clear();
+        for (const std::vector<std::uint64_t>& list : kept) active.insert(active.end(), list.begin(), list.end());
+        if (active.empty()) break;
+
+        roots.clear();
+        for (Vertex v = 0; v < num_vertices; v++) {
+            if (best[v].load(std::memory_order_relaxed) != NONE) roots.push_back(v);
+        }
+        // Two trees that picked the same edge join once; the second unite finds them joined already
+        pool.parallel_for(0, roots.size(), [&](std::size_t k, unsigned thread) {
+            std::uint64_t i = best[roots[k]].exchange(NONE, std::memory_order_relaxed);
+            if (sets.unite(edges[i].get_left(), edges[i].get_right())) joined[thread].push_back(edges[i]);
+        }, 256);
+        for (std::vector<Edge>& list : joined) {
+            for (const Edge& e : list) {
+                forest.edges.push_back(e);
+                forest.total_weight += e.get_weight();
+            }
+            list.clear();
+        }
+    }
+    forest.components = num_vertices - forest.edges.size();
+    return forest;
+}
+
+inline SpanningForest minimum_spanning_forest(const std::vector<Edge>& edges, std::size_t num_vertices, ThreadPool& pool,
+                                              SpanningForestMethod method = SpanningForestMethod::FILTER_KRUSKAL) {
+    if (method == SpanningForestMethod::KRUSKAL) return kruskal(edges, num_vertices, pool);
+    if (method == SpanningForestMethod::FILTER_KRUSKAL) return filter_kruskal(edges, num_vertices, pool);
+    if (method == SpanningForestMethod::BORUVKA) return boruvka(edges, num_vertices, pool);
+    throw std::runtime_error("Unknown spanning forest method");
+}
+
+// The minimum spanning forest of G, the greedy basis of its graphic matroid
+inline SpanningForest minimum_spanning_forest(Graph& G, SpanningForestMethod method = SpanningForestMethod::FILTER_KRUSKAL, unsigned threads = 0) {
+    ThreadPool pool(threads);
+    return minimum_spanning_forest(G.get_data(), G.num_vertices(), pool, method);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "IndexedHeap.hpp"
+#include "SearchStats.hpp"
+
+using Vertex = unsigned long;
+
+// Marks "no vertex": what prev holds for unreached vertices, and the 'end' to pass for a full one-to-all search
+constexpr Vertex NO_VERTEX = static_cast<Vertex>(-1);
+
+// The dist/prev labels and heap of one search, kept for reuse across queries by one thread. Every label
+// carries the epoch it was written in and counts as unreached once the epoch moves on, so reset() is
+// O(1) plus whatever is left in the heap, instead of O(V). ARITY is the arity of its d-ary heap.
+template <unsigned ARITY>
+class BasicQueryContext {
+    private:
+        std::vector<double> dist;
+        std::vector<Vertex> prev;
+        std::vector<std::uint32_t> stamp;
+        std::uint32_t epoch = 1;
+        std::size_t touched = 0;
+        IndexedHeap<double, ARITY> heap;
+        SearchStats stats;
+
+    public:
+        BasicQueryContext() {}
+        BasicQueryContext(std::size_t num_vertices) : dist(num_vertices), prev(num_vertices), stamp(num_vertices, 0), heap(num_vertices) {}
+
+        std::size_t num_vertices() const { return stamp.size(); }
+
+        // Grows the buffers for a larger graph; existing labels stay valid
+        void resize(std::size_t num_vertices) {
+            if (num_vertices <= stamp.size()) return;
+            dist.resize(num_vertices);
+            prev.resize(num_vertices);
+            stamp.resize(num_vertices, 0);
+            heap.resize(num_vertices);
+        }
+
+        // Forgets every label and counter; start of a new query
+        void reset() {
+            heap.clear();
+            touched = 0;
+            stats.clear();
+            if (++epoch == 0) {
+                // Wrapped around after 2^32 queries: old stamps could look current again
+                std::fill(stamp.begin(), stamp.end(), 0);
+                epoch = 1;
+            }
+        }
+
+        bool reached(Vertex v) const { return stamp[v] == epoch; }
+        double get_dist(Vertex v) const { return reached(v) ? dist[v] : 1.0 / 0.0; }
+        Vertex get_prev(Vertex v) const { return reached(v) ? prev[v] : NO_VERTEX; }
+
+        void label(Vertex v, double d, Vertex p) {
+            if (stamp[v] != epoch) {
+                stamp[v] = epoch;
+                touched++;
+            }
+            dist[v] = d;
+            prev[v] = p;
+        }
+
+        // Vertices labelled since the last reset
+        std::size_t num_touched() const { return touched; }
+
+        IndexedHeap<double, ARITY>& get_heap() { return heap; }
+
+        // Counters of the current query (all zero unless built with SHORTEST_PATH_STATS)
+        SearchStats& get_stats() { return stats; }
+        const SearchStats& get_stats() const { return stats; }
+
+        // Follows prev from end back to the root of the search (empty if end was not reached)
+        std::vector<Vertex> path_to(Vertex end) const {
+            std::vector<Vertex> path;
+            if (end >= stamp.size() or !reached(end)) return path;
+            Vertex at = end;
+            path.push_back(at);
+            while (prev[at] != at) {
+                at = prev[at];
+                path.push_back(at);
+            }
+            std::reverse(path.begin(), path.end());
+            return path;
+        }
+};
+
+// The 4-ary context. Every search that takes a context also accepts a BasicQueryContext of any other arity.
+using QueryContext = BasicQueryContext<4>;
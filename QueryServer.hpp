@@ -0,0 +1,370 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "BidirectionalDijkstra.hpp"
+#include "ContractionHierarchy.hpp"
+#include "ConcurrentQueue.hpp"
+#include "SearchStats.hpp"
+
+struct QueryResponse {
+    std::uint64_t id;
+    Vertex source;
+    Vertex target;
+    double distance;
+};
+
+// Where a worker sends the answer to a request; deliver() is called from worker threads
+class QuerySink {
+    public:
+        virtual ~QuerySink() {}
+        virtual void deliver(const QueryResponse& response) = 0;
+};
+
+struct QueryRequest {
+    std::uint64_t id;
+    Vertex source;
+    Vertex target;
+    QuerySink* sink;
+};
+
+// Point-to-point distance on a shared read-only graph; all mutable state lives in the two contexts
+template <typename GRAPH>
+double point_to_point_distance(const GRAPH& G, Vertex v, Vertex end, QueryContext& forward, QueryContext& backward) {
+    return std::get<0>(bidirectional_dijkstra(G, v, end, forward, backward));
+}
+
+inline double point_to_point_distance(const ContractionHierarchy& CH, Vertex v, Vertex end, QueryContext& forward, QueryContext& backward) {
+    return std::get<0>(CH.Query(v, end, forward, backward));
+}
+
+// Distribution of the queries a server has answered. Latency is always recorded; the search counters are
+// only non-zero when built with SHORTEST_PATH_STATS.
+struct ServerStats {
+    Histogram latency_ns;
+    Histogram settled;
+    Histogram relaxations;
+    SearchStats totals;
+
+    void merge(const ServerStats& other) {
+        latency_ns.merge(other.latency_ns);
+        settled.merge(other.settled);
+        relaxations.merge(other.relaxations);
+        totals += other.totals;
+    }
+};
+
+// Answers point-to-point queries against one immutable graph. Requests go into a lock-free MPMC queue and
+// a fixed set of workers pops them, each with its own pair of QueryContexts, so the only shared writes are
+// the two queue positions and queries scale with the number of cores. Idle workers spin briefly, then
+// yield, then sleep in short naps. The graph must outlive the server and must not change while it runs.
+template <typename GRAPH>
+class QueryServer {
+    private:
+        const GRAPH& graph;
+        ConcurrentQueue<QueryRequest> requests;
+        std::vector<std::thread> workers;
+        std::atomic<bool> stopping;
+
+        // Each worker records into its own stats; the lock is only ever contended by get_stats()
+        struct WorkerStats {
+            std::mutex mutex;
+            ServerStats stats;
+        };
+        std::vector<std::unique_ptr<WorkerStats>> worker_stats;
+
+        static void back_off(unsigned& idle) {
+            idle++;
+            if (idle < 64) return;
+            if (idle < 128) {
+                std::this_thread::yield();
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+
+        void work(WorkerStats& recorded) {
+            QueryContext forward(graph.num_vertices()), backward(graph.num_vertices());
+            QueryRequest request;
+            unsigned idle = 0;
+            while (true) {
+                if (requests.try_pop(request)) {
+                    idle = 0;
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    double distance = point_to_point_distance(graph, request.source, request.target, forward, backward);
+                    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+                    {
+                        std::lock_guard<std::mutex> lock(recorded.mutex);
+                        SearchStats query = forward.get_stats();
+                        query += backward.get_stats();
+                        recorded.stats.latency_ns.add(static_cast<std::uint64_t>(elapsed.count()));
+                        recorded.stats.settled.add(query.settled);
+                        recorded.stats.relaxations.add(query.relaxations);
+                        recorded.stats.totals += query;
+                    }
+                    request.sink->deliver(QueryResponse{request.id, request.source, request.target, distance});
+                }
+                else if (stopping.load(std::memory_order_acquire)) {
+                    return;
+                }
+                else {
+                    back_off(idle);
+                }
+            }
+        }
+
+    public:
+        // threads == 0 uses one worker per hardware core
+        QueryServer(const GRAPH& G, unsigned threads = 0, std::size_t capacity = 4096) : graph(G), requests(capacity), stopping(false) {
+            if (threads == 0) threads = std::thread::hardware_concurrency();
+            if (threads == 0) threads = 1;
+            for (unsigned i = 0; i < threads; i++) {
+                worker_stats.emplace_back(new WorkerStats());
+            }
+            for (unsigned i = 0; i < threads; i++) {
+                workers.emplace_back(&QueryServer::work, this, std::ref(*worker_stats[i]));
+            }
+        }
+
+        QueryServer(const QueryServer&) = delete;
+        QueryServer& operator=(const QueryServer&) = delete;
+
+        // Answers everything already submitted, then stops the workers
+        ~QueryServer() {
+            stopping.store(true, std::memory_order_release);
+            for (std::thread& worker : workers) worker.join();
+        }
+
+        unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+        // Everything answered so far, merged over the workers
+        ServerStats get_stats() const {
+            ServerStats merged;
+            for (const std::unique_ptr<WorkerStats>& recorded : worker_stats) {
+                std::lock_guard<std::mutex> lock(recorded->mutex);
+                merged.merge(recorded->stats);
+            }
+            return merged;
+        }
+
+        // Queues a request; waits while the queue is full. Safe to call from any number of threads.
+        void submit(const QueryRequest& request) {
+            unsigned idle = 0;
+            while (!requests.try_push(request)) back_off(idle);
+        }
+};
+
+// Text protocol: one "<source> <target>" query per line, answered by a "<source> <target> <distance>" line
+// ("inf" if unreachable). Answers come back in completion order, not request order; malformed lines get
+// an "error" line. A "stats" line is answered at once with a summary of everything answered so far.
+// A LineSink counts the queries still in flight so a connection can wait for them.
+class LineSink : public QuerySink {
+    private:
+        std::mutex mutex;
+        std::condition_variable idle;
+        std::size_t pending = 0;
+
+    protected:
+        // Called with the lock held, so lines never interleave
+        virtual void write_line(const char* text, std::size_t length) = 0;
+
+    public:
+        void expect() {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending++;
+        }
+
+        void deliver(const QueryResponse& response) override {
+            char text[96];
+            int length = std::snprintf(text, sizeof(text), "%lu %lu %.17g\n", response.source, response.target, response.distance);
+            std::lock_guard<std::mutex> lock(mutex);
+            write_line(text, static_cast<std::size_t>(length));
+            if (--pending == 0) idle.notify_all();
+        }
+
+        void reply(const std::string& text) {
+            std::lock_guard<std::mutex> lock(mutex);
+            write_line(text.data(), text.size());
+        }
+
+        // Returns once every expected query has been delivered
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            idle.wait(lock, [&] { return pending == 0; });
+        }
+};
+
+inline std::string format_stats(const ServerStats& stats) {
+    char text[256];
+    std::snprintf(text, sizeof(text),
+                  "stats queries %lu latency_us p50 %.1f p90 %.1f p99 %.1f max %.1f settled mean %.1f p99 %lu relaxations mean %.1f p99 %lu\n",
+                  static_cast<unsigned long>(stats.latency_ns.count()),
+                  stats.latency_ns.percentile(0.5) / 1e3, stats.latency_ns.percentile(0.9) / 1e3,
+                  stats.latency_ns.percentile(0.99) / 1e3, stats.latency_ns.max() / 1e3,
+                  stats.settled.mean(), static_cast<unsigned long>(stats.settled.percentile(0.99)),
+                  stats.relaxations.mean(), static_cast<unsigned long>(stats.relaxations.percentile(0.99)));
+    return text;
+}
+
+// Parses one protocol line and queues it; blank lines are ignored
+template <typename GRAPH>
+void submit_line(QueryServer<GRAPH>& server, LineSink& sink, const char* line, std::uint64_t id) {
+    const char* at = line;
+    while (*at == ' ' or *at == '\t' or *at == '\r') at++;
+    if (*at == '\0' or *at == '\n') return;
+    if (std::strncmp(at, "stats", 5) == 0 and (at[5] == '\0' or at[5] == '\n' or at[5] == ' ' or at[5] == '\t' or at[5] == '\r')) {
+        sink.reply(format_stats(server.get_stats()));
+        return;
+    }
+    char* next;
+    unsigned long long source = std::strtoull(at, &next, 10);
+    bool valid = next != at;
+    at = next;
+    unsigned long long target = std::strtoull(at, &next, 10);
+    valid = valid and next != at;
+    for (at = next; valid and *at != '\0' and *at != '\n'; at++) {
+        if (*at != ' ' and *at != '\t' and *at != '\r') valid = false;
+    }
+    if (!valid) {
+        sink.reply("error expected '<source> <target>'\n");
+        return;
+    }
+    sink.expect();
+    server.submit(QueryRequest{id, static_cast<Vertex>(source), static_cast<Vertex>(target), &sink});
+}
+
+class StreamSink : public LineSink {
+    private:
+        std::ostream& out;
+
+    protected:
+        void write_line(const char* text, std::size_t length) override {
+            out.write(text, static_cast<std::streamsize>(length));
+            out.flush();
+        }
+
+    public:
+        StreamSink(std::ostream& out) : out(out) {}
+};
+
+// Serves queries read from 'in' (e.g. stdin) until end of input and returns once all of them are answered
+template <typename GRAPH>
+void serve_stream(QueryServer<GRAPH>& server, std::istream& in, std::ostream& out) {
+    StreamSink sink(out);
+    std::string line;
+    std::uint64_t id = 0;
+    while (std::getline(in, line)) {
+        submit_line(server, sink, line.c_str(), id++);
+    }
+    sink.wait();
+}
+
+class SocketSink : public LineSink {
+    private:
+        int fd;
+
+    protected:
+        void write_line(const char* text, std::size_t length) override {
+            while (length > 0) {
+                ssize_t written = ::send(fd, text, length, MSG_NOSIGNAL);
+                // The client went away; its remaining answers are dropped
+                if (written <= 0) return;
+                text += written;
+                length -= static_cast<std::size_t>(written);
+            }
+        }
+
+    public:
+        SocketSink(int fd) : fd(fd) {}
+};
+
+// Serves one connected client until it closes its end, then closes the socket
+template <typename GRAPH>
+void serve_connection(QueryServer<GRAPH>& server, int fd) {
+    SocketSink sink(fd);
+    std::string pending;
+    std::uint64_t id = 0;
+    char buffer[1 << 16];
+    while (true) {
+        ssize_t got = ::read(fd, buffer, sizeof(buffer));
+        if (got < 0 and errno == EINTR) continue;
+        if (got <= 0) break;
+        pending.append(buffer, static_cast<std::size_t>(got));
+        std::size_t start = 0;
+        for (std::size_t newline; (newline = pending.find('\n', start)) != std::string::npos; start = newline + 1) {
+            pending[newline] = '\0';
+            submit_line(server, sink, pending.c_str() + start, id++);
+        }
+        pending.erase(0, start);
+    }
+    if (!pending.empty()) submit_line(server, sink, pending.c_str(), id++);
+    sink.wait();
+    ::close(fd);
+}
+
+// Listens on a Unix domain socket at 'path' and serves every client on its own reader thread; the queries
+// of all clients share the server's workers. Reader threads of closed connections are joined at the next
+// accept, so only open connections hold a thread. Runs until accept fails for good (e.g. the socket is shut
+// down); an interrupted accept or a client that gave up before being accepted is retried.
+template <typename GRAPH>
+void serve_unix_socket(QueryServer<GRAPH>& server, const std::string& path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path is too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) throw std::runtime_error("Cannot create a socket");
+    ::unlink(path.c_str());
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 or ::listen(listener, 64) != 0) {
+        ::close(listener);
+        throw std::runtime_error("Cannot listen on " + path);
+    }
+
+    struct Client {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+    std::vector<Client> clients;
+    while (true) {
+        int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR or errno == ECONNABORTED) continue;
+            break;
+        }
+        std::size_t open = 0;
+        for (std::size_t i = 0; i < clients.size(); i++) {
+            if (clients[i].done->load(std::memory_order_acquire)) clients[i].thread.join();
+            else if (open++ != i) std::swap(clients[open - 1], clients[i]);
+        }
+        clients.resize(open);
+        std::shared_ptr<std::atomic<bool>> done = std::make_shared<std::atomic<bool>>(false);
+        clients.push_back(Client{std::thread([&server, fd, done] {
+            serve_connection(server, fd);
+            done->store(true, std::memory_order_release);
+        }), done});
+    }
+    for (Client& client : clients) client.thread.join();
+    ::close(listener);
+    ::unlink(path.c_str());
+}
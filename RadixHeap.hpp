@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using Vertex = unsigned long;
+
+// Monotone radix heap (Ahuja, Mehlhorn, Orlin & Tarjan) over vertex ids with integer keys. Keys may never go
+// below the last popped key, which holds for Dijkstra with non-negative weights. Bucket i holds the keys whose
+// highest bit differing from the last popped key is bit i - 1 (bucket 0: equal to it), so a push is a bit scan
+// and a pop only compares keys when bucket 0 runs dry: then the smallest key of the first non-empty bucket
+// becomes the new reference and that bucket is spread over the lower ones. Each key moves down at most 64
+// times, and in practice far less often than a binary heap would compare it. Same interface as IndexedHeap,
+// including decrease-key, which moves the vertex to its new bucket.
+class RadixHeap {
+    private:
+        static constexpr std::size_t BUCKETS = 65;
+        static constexpr std::uint8_t NOT_IN_HEAP = 0xff;
+
+        struct Node {
+            std::uint64_t key;
+            Vertex vertex;
+        };
+
+        std::vector<Node> buckets[BUCKETS];
+        std::vector<std::uint8_t> bucket;  // per vertex
+        std::vector<std::size_t> slot;     // per vertex: position inside its bucket
+        std::uint64_t last = 0;
+        std::size_t count = 0;
+
+        std::size_t bucket_of(std::uint64_t key) const {
+            return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+        }
+
+        void place(const Node& node) {
+            std::size_t b = bucket_of(node.key);
+            bucket[node.vertex] = static_cast<std::uint8_t>(b);
+            slot[node.vertex] = buckets[b].size();
+            buckets[b].push_back(node);
+        }
+
+        void unlink(Vertex v) {
+            std::vector<Node>& from = buckets[bucket[v]];
+            Node moved = from.back();
+            from[slot[v]] = moved;
+            slot[moved.vertex] = slot[v];
+            from.pop_back();
+            bucket[v] = NOT_IN_HEAP;
+        }
+
+    public:
+        RadixHeap() {}
+        RadixHeap(std::size_t num_vertices) : bucket(num_vertices, NOT_IN_HEAP), slot(num_vertices) {}
+
+        void resize(std::size_t num_vertices) {
+            if (num_vertices <= bucket.size()) return;
+            bucket.resize(num_vertices, NOT_IN_HEAP);
+            slot.resize(num_vertices);
+        }
+
+        bool empty() const { return count == 0; }
+        std::size_t size() const { return count; }
+        bool contains(Vertex v) const { return v < bucket.size() and bucket[v] != NOT_IN_HEAP; }
+
+        std::uint64_t get_key(Vertex v) const { return buckets[bucket[v]][slot[v]].key; }
+
+        void push(Vertex v, std::uint64_t key) {
+            if (contains(v)) { throw std::runtime_error("Vertex is already in the heap"); }
+            if (key < last) { throw std::runtime_error("Radix heap keys cannot go below the last popped key"); }
+            place(Node{key, v});
+            count++;
+        }
+
+        void decrease_key(Vertex v, std::uint64_t key) {
+            if (key < last) { throw std::runtime_error("Radix heap keys cannot go below the last popped key"); }
+            unlink(v);
+            place(Node{key, v});
+        }
+
+        bool push_or_decrease(Vertex v, std::uint64_t key) {
+            if (!contains(v)) {
+                push(v, key);
+                return true;
+            }
+            if (!(key < get_key(v))) return false;
+            decrease_key(v, key);
+            return true;
+        }
+
+        Vertex pop() {
+            if (count == 0) { throw std::runtime_error("Cannot pop from an empty heap"); }
+            if (buckets[0].empty()) {
+                std::size_t b = 1;
+                while (buckets[b].empty()) b++;
+                std::uint64_t smallest = buckets[b][0].key;
+                for (const Node& node : buckets[b]) smallest = node.key < smallest ? node.key : smallest;
+                last = smallest;
+                std::vector<Node> spread;
+                spread.swap(buckets[b]);
+                // Every key in bucket b now differs from 'last' in a lower bit, so all of them land below b
+                for (const Node& node : spread) place(node);
+                spread.clear();
+                buckets[b].swap(spread);  // keep the capacity
+            }
+            Node node = buckets[0].back();
+            buckets[0].pop_back();
+            bucket[node.vertex] = NOT_IN_HEAP;
+            count--;
+            return node.vertex;
+        }
+
+        // Only touches the vertices still queued; the next search may start again from key 0
+        void clear() {
+            for (std::vector<Node>& nodes : buckets) {
+                for (const Node& node : nodes) bucket[node.vertex] = NOT_IN_HEAP;
+                nodes.clear();
+            }
+            last = 0;
+            count = 0;
+        }
+};
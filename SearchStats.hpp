@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Instrumentation of the search hot paths, switched at compile time: build with -DSHORTEST_PATH_STATS to
+// fill in the counters and timers. Without it every counting call below is an empty inline function and the
+// timers never read the clock, so the searches compile to the same code as before.
+#ifdef SHORTEST_PATH_STATS
+constexpr bool STATS_ENABLED = true;
+#else
+constexpr bool STATS_ENABLED = false;
+#endif
+
+// What one query did. A vertex is settled when it leaves the heap for good; stale entries are pops that were
+// thrown away (stalled vertices in a hierarchy, outdated bucket entries in delta-stepping). Relaxations count
+// every edge scanned from a settled vertex, whether or not it improved anything.
+struct SearchStats {
+    std::uint64_t pushes = 0;
+    std::uint64_t pops = 0;
+    std::uint64_t decrease_keys = 0;
+    std::uint64_t relaxations = 0;
+    std::uint64_t settled = 0;
+    std::uint64_t stale = 0;
+    double setup_seconds = 0;
+    double search_seconds = 0;
+
+    void clear() { *this = SearchStats(); }
+
+    SearchStats& operator+=(const SearchStats& other) {
+        pushes += other.pushes;
+        pops += other.pops;
+        decrease_keys += other.decrease_keys;
+        relaxations += other.relaxations;
+        settled += other.settled;
+        stale += other.stale;
+        setup_seconds += other.setup_seconds;
+        search_seconds += other.search_seconds;
+        return *this;
+    }
+};
+
+inline void stats_count(std::uint64_t& counter, std::uint64_t by = 1) {
+    if constexpr (STATS_ENABLED) counter += by;
+}
+
+// Call right before heap.push_or_decrease(v, ...) to count which of the two it will be
+template <typename HEAP>
+inline void stats_count_push(SearchStats& stats, const HEAP& heap, std::size_t v) {
+    if constexpr (STATS_ENABLED) {
+        if (heap.contains(v)) stats.decrease_keys++;
+        else stats.pushes++;
+    }
+}
+
+// Adds the lifetime of the timer to 'total' (in seconds) when instrumentation is on
+class ScopedTimer {
+    private:
+        double* total;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        ScopedTimer(double& total) : total(&total) {
+            if constexpr (STATS_ENABLED) start = std::chrono::steady_clock::now();
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        ~ScopedTimer() {
+            if constexpr (STATS_ENABLED) *total += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+};
+
+// Log-linear histogram of non-negative integers: 8 sub-buckets per power of two, so any recorded value is
+// reported within 12.5% and the whole thing is a fixed 496 counters that merge by addition.
+class Histogram {
+    private:
+        static constexpr unsigned SUB_BITS = 3;
+        static constexpr unsigned SUB = 1u << SUB_BITS;
+        std::vector<std::uint64_t> buckets;
+        std::uint64_t total = 0;
+        std::uint64_t largest = 0;
+        double sum = 0;
+
+        static std::size_t bucket_of(std::uint64_t value) {
+            if (value < SUB) return value;
+            unsigned exponent = 63 - __builtin_clzll(value);
+            return SUB + (exponent - SUB_BITS) * SUB + ((value >> (exponent - SUB_BITS)) & (SUB - 1));
+        }
+
+        // Smallest value that lands in bucket b
+        static std::uint64_t lower_bound_of(std::size_t b) {
+            if (b < SUB) return b;
+            unsigned exponent = static_cast<unsigned>((b - SUB) / SUB) + SUB_BITS;
+            return (SUB + (b - SUB) % SUB) << (exponent - SUB_BITS);
+        }
+
+    public:
+        Histogram() : buckets(SUB + (64 - SUB_BITS) * SUB, 0) {}
+
+        void add(std::uint64_t value) {
+            buckets[bucket_of(value)]++;
+            total++;
+            sum += value;
+            largest = std::max(largest, value);
+        }
+
+        void merge(const Histogram& other) {
+            for (std::size_t b = 0; b < buckets.size(); b++) buckets[b] += other.buckets[b];
+            total += other.total;
+            sum += other.sum;
+            largest = std::max(largest, other.largest);
+        }
+
+        void clear() { *this = Histogram(); }
+
+        std::uint64_t count() const { return total; }
+        std::uint64_t max() const { return largest; }
+        double mean() const { return total ? sum / total : 0; }
+
+        // Lower edge of the bucket holding the p-quantile (0 <= p <= 1)
+        std::uint64_t percentile(double p) const {
+            if (total == 0) return 0;
+            // Nearest rank: the smallest value with at least p of the samples at or below it
+            std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(p * total)));
+            std::uint64_t seen = 0;
+            for (std::size_t b = 0; b < buckets.size(); b++) {
+                seen += buckets[b];
+                if (seen >= rank) return std::min(lower_bound_of(b), largest);
+            }
+            return largest;
+        }
+};
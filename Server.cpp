@@ -0,0 +1,64 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "GraphLoader.hpp"
+#include "MappedGraph.hpp"
+#include "QueryServer.hpp"
+
+// Usage: server <graph> [--threads N] [--socket PATH]
+// <graph> is a packed graph file (see MappedGraph.hpp) or a DIMACS / edge list text file. Without --socket,
+// queries are read from stdin and answered on stdout (see QueryServer.hpp for the protocol).
+
+bool is_graph_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(GRAPH_FILE_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    return file and std::memcmp(magic, GRAPH_FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+template <typename GRAPH>
+void run(const GRAPH& G, unsigned threads, const std::string& socket_path) {
+    QueryServer<GRAPH> server(G, threads);
+    std::cerr << G.num_vertices() << " vertices, " << server.size() << " workers" << std::endl;
+    if (socket_path.empty()) {
+        serve_stream(server, std::cin, std::cout);
+    }
+    else {
+        serve_unix_socket(server, socket_path);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <graph> [--threads N] [--socket PATH]" << std::endl;
+        return 1;
+    }
+    std::string path = argv[1];
+    std::string socket_path;
+    unsigned threads = 0;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--threads") == 0) threads = static_cast<unsigned>(std::stoul(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--socket") == 0) socket_path = argv[i + 1];
+        else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        if (is_graph_file(path)) {
+            MappedGraph G(path, true);
+            run(G, threads, socket_path);
+        }
+        else {
+            CSRGraph G = load_csr_graph(path, detect_format(path));
+            run(G, threads, socket_path);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "Graph.hpp"
+
+// Arc weights that may be negative
+using SignedWeight = long;
+
+// One directed arc from -> to
+struct SignedEdge {
+    Vertex from;
+    Vertex to;
+    SignedWeight weight;
+};
+
+// A frozen directed graph with signed arc weights in compressed sparse row form, for Bellman-Ford
+// (BellmanFord.hpp). Arcs only go one way: an undirected edge of negative weight would already be a negative
+// cycle of two arcs. The scan is called for_each_arc rather than for_each_neighbor so that this graph cannot
+// be handed to the Dijkstra engines, which read weights as unsigned Weights, by mistake.
+class SignedGraph {
+    private:
+        std::vector<std::uint64_t> offsets;
+        std::vector<Vertex> targets;
+        std::vector<SignedWeight> weights;
+
+        // Counting sort by tail: count out-degrees, prefix-sum into offsets, then scatter every arc into its row
+        template <typename EACH_ARC>
+        void build(EACH_ARC&& each_arc, std::size_t num_vertices) {
+            std::size_t num_arcs = 0;
+            each_arc([&](Vertex from, Vertex to, SignedWeight) {
+                num_vertices = std::max(num_vertices, std::max(from, to) + 1);
+                num_arcs++;
+            });
+            offsets.assign(num_vertices + 1, 0);
+            each_arc([&](Vertex from, Vertex, SignedWeight) { offsets[from + 1]++; });
+            for (std::size_t i = 0; i < num_vertices; i++) {
+                offsets[i + 1] += offsets[i];
+            }
+            targets.resize(num_arcs);
+            weights.resize(num_arcs);
+            std::vector<std::uint64_t> cursor(offsets.begin(), offsets.end() - 1);
+            each_arc([&](Vertex from, Vertex to, SignedWeight weight) {
+                std::uint64_t slot = cursor[from]++;
+                targets[slot] = to;
+                weights[slot] = weight;
+            });
+        }
+
+    public:
+        SignedGraph() : offsets(1, 0) {}
+
+        // num_vertices may be larger than the highest id to keep trailing isolated vertices
+        SignedGraph(const std::vector<SignedEdge>& arcs, std::size_t num_vertices = 0) {
+            build([&](auto&& f) {
+                for (const SignedEdge& a : arcs) f(a.from, a.to, a.weight);
+            }, num_vertices);
+        }
+
+        // Both directions of every edge of an undirected graph
+        SignedGraph(Graph& G) {
+            build([&](auto&& f) {
+                for (const Edge& e : G.get_data()) {
+                    SignedWeight weight = static_cast<SignedWeight>(e.get_weight());
+                    f(e.get_left(), e.get_right(), weight);
+                    if (e.get_left() != e.get_right()) f(e.get_right(), e.get_left(), weight);
+                }
+            }, G.num_vertices());
+        }
+
+        std::size_t num_vertices() const { return offsets.size() - 1; }
+        std::size_t num_arcs() const { return targets.size(); }
+
+        std::size_t out_degree(Vertex v) const { return offsets[v + 1] - offsets[v]; }
+
+        // Calls f(w, weight) for every arc v -> w
+        template <typename FUNCTION>
+        void for_each_arc(Vertex v, FUNCTION&& f) const {
+            for (std::uint64_t i = offsets[v]; i < offsets[v + 1]; i++) {
+                f(targets[i], weights[i]);
+            }
+        }
+};
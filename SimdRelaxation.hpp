@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <vector>
+#include "Dijkstra.hpp"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SHORTEST_PATH_X86 1
+#endif
+
+// Vectorized relaxation of one packed neighbor row (the targets/weights arrays of CSRGraph and MappedGraph):
+// load a block of targets and weights, gather the current distances of the targets, add the weights to the
+// distance of the settled vertex and compare, all in registers, and write out only the positions that
+// improved. The kernels are compiled for AVX2 and AVX-512 with target attributes, so the rest of the program
+// needs no special flags, and the widest one the CPU supports is picked once at run time.
+enum class SimdLevel { SCALAR, AVX2, AVX512 };
+
+inline const char* simd_level_name(SimdLevel level) {
+    if (level == SimdLevel::AVX512) return "avx512";
+    if (level == SimdLevel::AVX2) return "avx2";
+    return "scalar";
+}
+
+// Writes every i < count with du + weights[i] < dist[targets[i]] to 'improved' (in increasing order) and
+// returns how many there were. 'improved' must have room for count entries.
+using RelaxKernel = std::size_t (*)(const std::uint32_t* targets, const std::uint32_t* weights, std::size_t count, double du,
+                                    const double* dist, std::uint32_t* improved);
+
+// 'first' is added to every position written, so the vector kernels can hand their tail to it
+inline std::size_t relax_scalar_from(std::size_t first, const std::uint32_t* targets, const std::uint32_t* weights, std::size_t count,
+                                     double du, const double* dist, std::uint32_t* improved) {
+    std::size_t found = 0;
+    for (std::size_t i = first; i < count; i++) {
+        // Branch-free append: the slot is written either way and only kept if the edge improves
+        improved[found] = static_cast<std::uint32_t>(i);
+        found += du + weights[i] < dist[targets[i]];
+    }
+    return found;
+}
+
+inline std::size_t relax_scalar(const std::uint32_t* targets, const std::uint32_t* weights, std::size_t count, double du,
+                                const double* dist, std::uint32_t* improved) {
+    return relax_scalar_from(0, targets, weights, count, du, dist, improved);
+}
+
+#ifdef SHORTEST_PATH_X86
+__attribute__((target("avx2"))) inline std::size_t relax_avx2(const std::uint32_t* targets, const std::uint32_t* weights, std::size_t count,
+                                                             double du, const double* dist, std::uint32_t* improved) {
+    std::size_t found = 0, i = 0;
+    __m256d base = _mm256_set1_pd(du);
+    __m256d two_to_32 = _mm256_set1_pd(4294967296.0);
+    __m256d zero = _mm256_setzero_pd();
+    __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    for (; i + 4 <= count; i += 4) {
+        __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(targets + i));
+        __m128i weight = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        // AVX2 only converts signed integers; weights of 2^31 and more come out negative and get 2^32 back
+        __m256d w = _mm256_cvtepi32_pd(weight);
+        w = _mm256_add_pd(w, _mm256_and_pd(_mm256_cmp_pd(w, zero, _CMP_LT_OQ), two_to_32));
+        __m256d candidate = _mm256_add_pd(base, w);
+        // The masked form with an explicit source; the plain one starts from an undefined register
+        __m256d current = _mm256_mask_i32gather_pd(zero, dist, index, all, 8);
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(candidate, current, _CMP_LT_OQ)));
+        while (mask) {
+            improved[found++] = static_cast<std::uint32_t>(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    return found + relax_scalar_from(i, targets, weights, count, du, dist, improved + found);
+}
+
+__attribute__((target("avx512f"))) inline std::size_t relax_avx512(const std::uint32_t* targets, const std::uint32_t* weights, std::size_t count,
+                                                                 double du, const double* dist, std::uint32_t* improved) {
+    std::size_t found = 0, i = 0;
+    __m512d base = _mm512_set1_pd(du);
+    __m512d zero = _mm512_setzero_pd();
+    __m512i lanes = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    for (; i + 8 <= count; i += 8) {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(targets + i));
+        __m256i weight = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        // Masked forms with an explicit source throughout; the plain ones start from an undefined register
+        __m512d candidate = _mm512_add_pd(base, _mm512_mask_cvtepu32_pd(zero, 0xff, weight));
+        __m512d current = _mm512_mask_i32gather_pd(zero, 0xff, index, dist, 8);
+        __mmask8 mask = _mm512_cmp_pd_mask(candidate, current, _CMP_LT_OQ);
+        // Packs the positions of the improved lanes next to each other in one store
+        __m512i positions = _mm512_add_epi32(lanes, _mm512_set1_epi32(static_cast<int>(i)));
+        _mm512_mask_compressstoreu_epi32(improved + found, mask, positions);
+        found += static_cast<std::size_t>(__builtin_popcount(mask));
+    }
+    return found + relax_scalar_from(i, targets, weights, count, du, dist, improved + found);
+}
+#endif
+
+inline SimdLevel detect_simd_level() {
+#ifdef SHORTEST_PATH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+// The widest level this CPU runs, detected on first use
+inline SimdLevel best_simd_level() {
+    static const SimdLevel level = detect_simd_level();
+    return level;
+}
+
+// The kernel for 'level', or for the best level below it that this CPU supports
+inline RelaxKernel relax_kernel(SimdLevel level) {
+    if (static_cast<int>(level) > static_cast<int>(best_simd_level())) level = best_simd_level();
+#ifdef SHORTEST_PATH_X86
+    if (level == SimdLevel::AVX512) return relax_avx512;
+    if (level == SimdLevel::AVX2) return relax_avx2;
+#endif
+    return relax_scalar;
+}
+
+// Rows with fewer neighbors are relaxed one edge at a time
+constexpr std::size_t SIMD_MIN_ROW = 16;
+
+// Dijkstra over a packed graph (anything with num_vertices() and row(v), i.e. CSRGraph or MappedGraph) that
+// relaxes each settled vertex's whole row with the vectorized kernel when the row is long enough. Only the improved targets are
+// rechecked one by one (a row may hold parallel edges) and queued. Same results as dijkstra(). The gathers take
+// signed 32-bit indices, so graphs with 2^31 vertices or more fall back to the scalar kernel.
+template <typename GRAPH>
+std::tuple<std::vector<double>, std::vector<Vertex>> simd_dijkstra(const GRAPH& G, Vertex v, Vertex end, SearchStats& stats,
+                                                                  SimdLevel level = best_simd_level()) {
+    double inf = 1.0 / 0.0;
+    std::size_t n = G.num_vertices();
+    if (n > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max())) level = SimdLevel::SCALAR;
+    RelaxKernel relax = relax_kernel(level);
+    std::vector<double> dist;
+    std::vector<Vertex> prev;
+    std::vector<std::uint32_t> improved;
+    IndexedHeap<double, 4> pq;
+    {
+        ScopedTimer timer(stats.setup_seconds);
+        dist.assign(n, inf);
+        prev.assign(n, NO_VERTEX);
+        pq.resize(n);
+    }
+    if (v >= n) { return std::tuple(dist, prev); }
+
+    ScopedTimer timer(stats.search_seconds);
+    dist[v] = 0;
+    prev[v] = v;
+    pq.push(v, 0);
+    stats_count(stats.pushes);
+    while (!pq.empty()) {
+        Vertex u = pq.pop();
+        stats_count(stats.pops);
+        stats_count(stats.settled);
+        if (u == end) break;
+        double du = dist[u];
+        auto [targets, weights, count] = G.row(u);
+        stats_count(stats.relaxations, count);
+        auto improve = [&](std::size_t i) {
+            Vertex w = targets[i];
+            double candidate = du + weights[i];
+            if (candidate < dist[w]) {
+                dist[w] = candidate;
+                prev[w] = u;
+                stats_count_push(stats, pq, w);
+                pq.push_or_decrease(w, candidate);
+            }
+        };
+        // Short rows do not fill enough vector lanes to pay for the call and the second pass
+        if (count < SIMD_MIN_ROW) {
+            for (std::size_t i = 0; i < count; i++) improve(i);
+            continue;
+        }
+        if (improved.size() < count) improved.resize(count);
+        std::size_t found = relax(targets, weights, count, du, dist.data(), improved.data());
+        for (std::size_t k = 0; k < found; k++) improve(improved[k]);
+    }
+    return std::tuple(dist, prev);
+}
+
+template <typename GRAPH>
+std::tuple<std::vector<double>, std::vector<Vertex>> simd_dijkstra(const GRAPH& G, Vertex v, Vertex end = NO_VERTEX,
+                                                                  SimdLevel level = best_simd_level()) {
+    SearchStats stats;
+    return simd_dijkstra(G, v, end, stats, level);
+}
@@ -2,7 +2,26 @@
 #include <cassert>
 #include <vector>
 #include <tuple>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
 #include "Graph.hpp"
+#include "CSRGraph.hpp"
+#include "MappedGraph.hpp"
+#include "GraphLoader.hpp"
+#include "ContractionHierarchy.hpp"
+#include "DistanceMatrix.hpp"
+#include "QueryServer.hpp"
+#include "GraphGenerators.hpp"
+#include "DynamicShortestPaths.hpp"
+#include "CustomizableRoutePlanner.hpp"
+#include "VertexOrder.hpp"
+#include "BellmanFord.hpp"
+#include "DirectedGraph.hpp"
+#include "AllPairs.hpp"
+#include "MinimumSpanningTree.hpp"
 
 void print_path(const std::vector<Vertex>& prev, Vertex start, Vertex end) {
     std::vector<Vertex> path;
@@ -111,6 +130,1175 @@ int main() {
         // You can add asserts based on expected distance if known
     }
 
+    // === Test Case 6: Heap arity and early termination ===
+    {
+        std::cout << "=== Test 6: Heap arity ===\n";
+        std::vector<Edge> edges = {
+            Edge(0, 1, 4), Edge(0, 2, 3), Edge(1, 3, 2), Edge(2, 3, 5),
+            Edge(3, 4, 1), Edge(4, 5, 7), Edge(5, 6, 2), Edge(6, 7, 1),
+            Edge(2, 6, 12), Edge(7, 8, 4), Edge(8, 9, 3), Edge(9, 10, 6)
+        };
+        Graph G(edges);
+
+        auto [dist2, prev2] = G.Dijkstra<2>(0, NO_VERTEX);
+        auto [dist8, prev8] = G.Dijkstra<8>(0, NO_VERTEX);
+        assert(dist2 == dist8);
+        assert(dist2[10] == 29);
+
+        // Stopping at 3 must still give its final distance
+        auto [dist, prev] = G.Dijkstra(0, 3);
+        assert(dist[3] == 6);
+        assert(prev[3] == 1);
+        print_path(prev, 0, 3);
+    }
+
+    // === Test Case 7: CSR view gives the same distances ===
+    {
+        std::cout << "=== Test 7: CSR graph ===\n";
+        std::vector<Edge> edges = {
+            Edge(0, 1, 4), Edge(0, 2, 3), Edge(1, 3, 2), Edge(2, 3, 5),
+            Edge(3, 4, 1), Edge(4, 5, 7), Edge(5, 6, 2), Edge(6, 7, 1),
+            Edge(2, 6, 12), Edge(7, 8, 4), Edge(8, 9, 3), Edge(9, 10, 6)
+        };
+        Graph G(edges);
+        CSRGraph C(G);
+        assert(C.num_vertices() == G.num_vertices());
+        assert(C.num_slots() == 2 * edges.size());
+        assert(C.degree(3) == 3);
+
+        auto [dist, prev] = G.Dijkstra(0, NO_VERTEX);
+        auto [csr_dist, csr_prev] = C.Dijkstra(0, NO_VERTEX);
+        assert(dist == csr_dist);
+        print_path(csr_prev, 0, 10);
+    }
+
+    // === Test Case 8: Graph file round trip through mmap ===
+    {
+        std::cout << "=== Test 8: Mapped graph file ===\n";
+        std::vector<Edge> edges = {
+            Edge(0, 1, 10), Edge(0, 2, 2), Edge(2, 3, 2), Edge(3, 1, 2)
+        };
+        Graph G(edges);
+        std::vector<Coordinate> coordinates = {{0, 0}, {3, 0}, {1, 1}, {2, 1}};
+        std::string path = "test_graph.spg";
+        write_graph_file(path, G, &coordinates);
+        {
+            MappedGraph M(path);
+            assert(M.num_vertices() == 4);
+            assert(M.has_coordinates() and M.get_coordinate(3).x == 2);
+            auto [dist, prev] = M.Dijkstra(0, 1);
+            assert(dist[1] == 6);
+            print_path(prev, 0, 1);
+        }
+
+        // Corrupt headers are rejected before anything is read through them
+        auto rejects = [&](std::size_t position, std::uint64_t value) {
+            write_graph_file(path, G, &coordinates);
+            {
+                std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+                file.seekp(position);
+                file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+            }
+            try {
+                MappedGraph M(path);
+            } catch (const std::runtime_error&) {
+                return true;
+            }
+            return false;
+        };
+        assert(rejects(offsetof(GraphFileHeader, targets_offset), std::uint64_t(1) << 62));
+        assert(rejects(offsetof(GraphFileHeader, weights_offset), 65));
+        assert(rejects(offsetof(GraphFileHeader, coordinates_offset), 0));
+        assert(rejects(offsetof(GraphFileHeader, num_vertices), static_cast<std::uint64_t>(-1)));
+        assert(rejects(offsetof(GraphFileHeader, num_slots), std::uint64_t(1) << 62));
+        assert(rejects(offsetof(GraphFileHeader, num_slots), 6));
+        assert(!rejects(0, 0x0048504152475053));  // the magic itself, rewritten unchanged
+        std::remove(path.c_str());
+    }
+
+    // === Test Case 9: Text loaders ===
+    {
+        std::cout << "=== Test 9: DIMACS and edge list loading ===\n";
+        std::string dimacs = "c tiny road graph\np sp 4 4\na 1 2 10\na 1 3 2\na 3 4 2\na 4 2 2\n";
+        std::string csv = "from,to,weight\n0,1,10\n0,2,2\n# detour\n2,3,2\n3,1,2";
+        std::string dimacs_path = "test_graph.gr", csv_path = "test_graph.csv";
+        std::ofstream(dimacs_path) << dimacs;
+        std::ofstream(csv_path) << csv;
+        assert(detect_format(dimacs_path) == EdgeListFormat::DIMACS);
+
+        LoadStats stats;
+        CSRGraph C = load_csr_graph(dimacs_path, EdgeListFormat::DIMACS, &stats);
+        assert(stats.edges == 4 and stats.bytes == dimacs.size());
+        auto [dist, prev] = C.Dijkstra(1, 2);
+        assert(dist[2] == 6);
+
+        Graph G = load_graph(csv_path, detect_format(csv_path));
+        auto [csv_dist, csv_prev] = G.Dijkstra(0, 1);
+        assert(csv_dist[1] == 6);
+        print_path(csv_prev, 0, 1);
+
+        // Force several chunks on a tiny input to exercise the line-boundary splitting
+        std::vector<std::vector<Edge>> chunks = parse_edge_chunks(csv.data(), csv.size(), EdgeListFormat::EDGE_LIST, 4, 8);
+        std::size_t total = 0;
+        for (auto& chunk : chunks) total += chunk.size();
+        assert(chunks.size() > 1 and total == 4);
+
+        // A number too long for 64 bits is a parse error, not a wrapped id
+        std::string too_long = "0 1 5\n2 18446744073709551616 3\n";
+        bool overflowed = false;
+        try {
+            parse_edge_chunks(too_long.data(), too_long.size(), EdgeListFormat::EDGE_LIST, 1);
+        } catch (const std::runtime_error& error) {
+            overflowed = std::string(error.what()) == "Integer too large at byte 27";
+        }
+        assert(overflowed);
+        std::string largest = "0 18446744073709551615 3\n";
+        assert(parse_edge_chunks(largest.data(), largest.size(), EdgeListFormat::EDGE_LIST, 1)[0][0].get_left() == 18446744073709551615ul);
+
+        std::remove(dimacs_path.c_str());
+        std::remove(csv_path.c_str());
+    }
+
+    // === Test Case 10: Bidirectional search matches one-directional ===
+    {
+        std::cout << "=== Test 10: Bidirectional Dijkstra ===\n";
+        std::mt19937 rng(7);
+        std::vector<Edge> edges;
+        for (Vertex i = 1; i < 200; i++) {
+            edges.push_back(Edge(i, rng() % i, 1 + rng() % 20));
+            edges.push_back(Edge(i, rng() % 200, 1 + rng() % 20));
+        }
+        Graph G(edges);
+
+        auto [dist, prev] = G.Dijkstra(5, NO_VERTEX);
+        for (Vertex end = 0; end < 200; end += 13) {
+            auto [length, path] = G.BidirectionalDijkstra(5, end);
+            assert(length == dist[end]);
+            assert(path.front() == 5 and path.back() == end);
+            double walked = 0;
+            for (std::size_t i = 0; i + 1 < path.size(); i++) {
+                double best = 1.0 / 0.0;
+                G.for_each_neighbor(path[i], [&](Vertex w, Weight weight) {
+                    if (w == path[i + 1] and weight < best) best = weight;
+                });
+                walked += best;
+            }
+            assert(walked == length);
+
+            // Any heap arity, through the member or on reused contexts
+            assert(std::get<0>(G.BidirectionalDijkstra<2>(5, end)) == length);
+            BasicQueryContext<8> forward8, backward8;
+            assert(std::get<0>(bidirectional_dijkstra(G, 5, end, forward8, backward8)) == length);
+        }
+        auto [length, path] = G.BidirectionalDijkstra(5, 150);
+        std::cout << "Distance to 150: " << length << std::endl;
+    }
+
+    // === Test Case 11: A* heuristics and ALT landmarks ===
+    {
+        std::cout << "=== Test 11: A* ===\n";
+        // A 12x12 grid whose weights are at least the Euclidean length (10 per unit) plus some noise
+        std::mt19937 rng(3);
+        std::size_t side = 12;
+        std::vector<Edge> edges;
+        std::vector<Coordinate> coordinates;
+        for (Vertex r = 0; r < side; r++) {
+            for (Vertex c = 0; c < side; c++) {
+                Vertex v = r * side + c;
+                coordinates.push_back(Coordinate{double(c), double(r)});
+                if (c + 1 < side) edges.push_back(Edge(v, v + 1, 10 + rng() % 10));
+                if (r + 1 < side) edges.push_back(Edge(v, v + side, 10 + rng() % 10));
+            }
+        }
+        Graph G(edges);
+        double scale = admissible_scale<EuclideanHeuristic>(G, coordinates);
+        assert(scale == 10);
+
+        Landmarks farthest(G, 4);
+        Landmarks avoid(G, 4, LandmarkSelection::AVOID);
+        assert(farthest.size() == 4 and avoid.size() == 4);
+        farthest.save("test_graph.landmarks");
+        Landmarks loaded = Landmarks::load("test_graph.landmarks");
+        std::remove("test_graph.landmarks");
+        assert(loaded.get_landmarks() == farthest.get_landmarks());
+
+        for (Vertex end : {Vertex(143), Vertex(77), Vertex(12)}) {
+            auto [dist, prev] = G.Dijkstra(0, NO_VERTEX);
+            assert(std::get<0>(G.AStar(0, end, ZeroHeuristic())) == std::get<0>(G.Dijkstra(0, end)));
+            assert(std::get<0>(G.AStar(0, end, EuclideanHeuristic(coordinates, scale)))[end] == dist[end]);
+            assert(std::get<0>(G.AStar(0, end, LandmarkHeuristic(loaded)))[end] == dist[end]);
+            assert(std::get<0>(G.AStar(0, end, LandmarkHeuristic(avoid)))[end] == dist[end]);
+            assert(loaded.lower_bound(0, end) <= dist[end]);
+        }
+        auto [dist, prev] = G.AStar(0, 143, LandmarkHeuristic(farthest));
+        print_path(prev, 0, 143);
+    }
+
+    // === Test Case 12: Contraction hierarchy queries ===
+    {
+        std::cout << "=== Test 12: Contraction Hierarchies ===\n";
+        std::mt19937 rng(11);
+        std::vector<Edge> edges;
+        for (Vertex i = 1; i < 300; i++) {
+            edges.push_back(Edge(i, rng() % i, 1 + rng() % 50));
+            edges.push_back(Edge(i, rng() % 300, 1 + rng() % 50));
+        }
+        edges.push_back(Edge(301, 302, 4));  // a separate component
+        Graph G(edges);
+        ContractionHierarchy CH(G, 2);
+        CH.save("test_graph.ch");
+        ContractionHierarchy loaded = ContractionHierarchy::load("test_graph.ch");
+        std::remove("test_graph.ch");
+        assert(loaded.num_up_edges() == CH.num_up_edges());
+
+        for (Vertex start : {Vertex(0), Vertex(17), Vertex(250)}) {
+            auto [dist, prev] = G.Dijkstra(start, NO_VERTEX);
+            for (Vertex end = 0; end < G.num_vertices(); end += 7) {
+                auto [length, path] = loaded.Query(start, end);
+                assert(length == dist[end]);
+                if (length == 1.0 / 0.0) continue;
+                assert(path.front() == start and path.back() == end);
+                double walked = 0;
+                for (std::size_t i = 0; i + 1 < path.size(); i++) {
+                    double best = 1.0 / 0.0;
+                    G.for_each_neighbor(path[i], [&](Vertex w, Weight weight) {
+                        if (w == path[i + 1] and weight < best) best = weight;
+                    });
+                    walked += best;
+                }
+                assert(walked == length);
+            }
+        }
+        auto [length, path] = CH.Query(0, 299);
+        std::cout << "Distance to 299: " << length << std::endl;
+    }
+
+    // === Test Case 13: Delta-stepping matches Dijkstra ===
+    {
+        std::cout << "=== Test 13: Delta-stepping ===\n";
+        std::mt19937 rng(5);
+        std::vector<Edge> edges;
+        for (Vertex i = 1; i < 500; i++) {
+            edges.push_back(Edge(i, rng() % i, rng() % 100));  // includes some zero weights
+            edges.push_back(Edge(i, rng() % 500, 1 + rng() % 1000));
+        }
+        edges.push_back(Edge(600, 601, 1));
+        Graph G(edges);
+
+        auto [dist, prev] = G.Dijkstra(3, NO_VERTEX);
+        ThreadPool pool(4);
+        for (double delta : {0.0, 1.0, 50.0, 5000.0}) {
+            auto [parallel_dist, parallel_prev] = delta_stepping(G, 3, pool, delta);
+            assert(parallel_dist == dist);
+            for (Vertex w = 0; w < G.num_vertices(); w++) {
+                if (dist[w] == 1.0 / 0.0 or w == 3) {
+                    assert(parallel_prev[w] == prev[w]);
+                    continue;
+                }
+                // Following prev must walk back to the source without looping
+                Vertex at = w;
+                for (std::size_t steps = 0; at != 3; steps++) {
+                    assert(steps < G.num_vertices());
+                    at = parallel_prev[at];
+                }
+            }
+        }
+        auto [parallel_dist, parallel_prev] = G.DeltaStepping(3);
+        print_path(parallel_prev, 3, 499);
+
+        // A tiny delta against heavy weights on a long path: the bucket ring stays at ceil(max / delta) + 2
+        // slots and the empty buckets in between are skipped
+        std::vector<Edge> heavy_path;
+        for (Vertex i = 1; i < 5000; i++) heavy_path.push_back(Edge(i - 1, i, 1000000 + rng() % 1000));
+        Graph P(heavy_path);
+        auto [path_dist, path_prev] = delta_stepping(P, 0, pool, 1000.0);
+        assert(path_dist == std::get<0>(P.Dijkstra(0, NO_VERTEX)) and path_prev[4999] == 4998);
+    }
+
+    // === Test Case 14: Many-to-many distance tables ===
+    {
+        std::cout << "=== Test 14: Distance matrix ===\n";
+        std::mt19937 rng(9);
+        std::vector<Edge> edges;
+        for (Vertex i = 1; i < 400; i++) {
+            edges.push_back(Edge(i, rng() % i, 1 + rng() % 30));
+            edges.push_back(Edge(i, rng() % 400, 1 + rng() % 30));
+        }
+        edges.push_back(Edge(400, 401, 2));
+        Graph G(edges);
+        ContractionHierarchy CH(G);
+
+        std::vector<Vertex> sources = {0, 7, 99, 400, 250};
+        std::vector<Vertex> targets = {5, 401, 300, 5, 0, 123};
+        std::vector<double> table(sources.size() * targets.size());
+        std::vector<double> ch_table(sources.size() * targets.size());
+        ThreadPool pool(3);
+        distance_matrix(G, sources, targets, table.data(), pool);
+        distance_matrix(CH, sources, targets, ch_table.data(), pool);
+        std::vector<double> binary_table(sources.size() * targets.size());
+        distance_matrix<2>(G, sources, targets, binary_table.data(), pool);
+        assert(binary_table == table);
+        for (std::size_t i = 0; i < sources.size(); i++) {
+            auto [dist, prev] = G.Dijkstra(sources[i], NO_VERTEX);
+            for (std::size_t j = 0; j < targets.size(); j++) {
+                assert(table[i * targets.size() + j] == dist[targets[j]]);
+                assert(ch_table[i * targets.size() + j] == dist[targets[j]]);
+            }
+        }
+        std::cout << "Distance 0 -> 123: " << table[5] << std::endl;
+    }
+
+    // === Test Case 15: One QueryContext reused across queries ===
+    {
+        std::cout << "=== Test 15: Query contexts ===\n";
+        std::mt19937 rng(21);
+        std::vector<Edge> edges;
+        for (Vertex i = 1; i < 300; i++) {
+            edges.push_back(Edge(i, rng() % i, 1 + rng() % 20));
+            edges.push_back(Edge(i, rng() % 300, 1 + rng() % 20));
+        }
+        Graph G(edges);
+        ContractionHierarchy CH(G);
+        QueryContext ctx, forward, backward;
+        BasicQueryContext<2> binary, binary_forward, binary_backward;
+        for (int q = 0; q < 50; q++) {
+            Vertex v = rng() % 300, end = rng() % 300;
+            auto [dist, prev] = G.Dijkstra(v, NO_VERTEX);
+            assert(dijkstra(G, v, end, ctx) == dist[end]);
+            std::vector<Vertex> path = ctx.path_to(end);
+            assert(path.front() == v and path.back() == end);
+            auto [bidirectional, bidirectional_path] = bidirectional_dijkstra(G, v, end, forward, backward);
+            assert(bidirectional == dist[end]);
+            auto [ch, ch_path] = CH.Query(v, end, forward, backward);
+            assert(ch == dist[end] and ch_path.front() == v and ch_path.back() == end);
+            // The same searches on contexts with a binary heap
+            assert(dijkstra(G, v, end, binary) == dist[end]);
+            assert(std::get<0>(CH.Query(v, end, binary_forward, binary_backward)) == dist[end]);
+        }
+
+        // A query that stops at the nearest neighbor of v only labels the neighborhoods of the two
+        Vertex v = 7, end = 7;
+        Weight nearest = 1 << 30;
+        G.for_each_neighbor(v, [&](Vertex w, Weight weight) {
+            if (weight < nearest) { nearest = weight; end = w; }
+        });
+        dijkstra(G, v, end, ctx);
+        assert(ctx.get_dist(end) == nearest);
+        assert(ctx.num_touched() < 40);
+        std::cout << "Labels touched by a short query: " << ctx.num_touched() << std::endl;
+    }
+
+    // === Test Case 16: Concurrent query server ===
+    {
+        std::cout << "=== Test 16: Query server ===\n";
+        // Four producers and four consumers through a small ring: every value comes out exactly once
+        ConcurrentQueue<unsigned long> queue(64);
+        std::atomic<unsigned long> sum(0), count(0);
+        std::vector<std::thread> threads;
+        for (unsigned long t = 0; t < 4; t++) {
+            threads.emplace_back([&, t] {
+                for (unsigned long i = 1; i <= 10000; i++) {
+                    while (!queue.try_push(t * 10000 + i)) std::this_thread::yield();
+                }
+            });
+            threads.emplace_back([&] {
+                unsigned long value;
+                while (count.load() < 40000) {
+                    if (queue.try_pop(value)) {
+                        sum += value;
+                        count++;
+                    }
+                    else std::this_thread::yield();
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+        assert(count == 40000 and sum == 40000ul * 40001 / 2);
+
+        std::mt19937 rng(5);
+        std::vector<Edge> edges;
+        for (Vertex i = 1; i < 500; i++) {
+            edges.push_back(Edge(i, rng() % i, 1 + rng() % 40));
+            edges.push_back(Edge(i, rng() % 500, 1 + rng() % 40));
+        }
+        edges.push_back(Edge(500, 501, 3));
+        const Graph G(edges);
+        assert(G.connected(0, 499) and !G.connected(0, 501));
+
+        std::string input;
+        std::vector<std::pair<Vertex, Vertex>> queries;
+        for (int q = 0; q < 200; q++) {
+            queries.push_back({rng() % 502, rng() % 502});
+            input += std::to_string(queries.back().first) + " " + std::to_string(queries.back().second) + "\n";
+        }
+        input += "\nnot a query\n";
+        std::istringstream in(input);
+        std::ostringstream out;
+        {
+            QueryServer<Graph> server(G, 4, 16);
+            serve_stream(server, in, out);
+        }
+
+        std::istringstream answers(out.str());
+        std::string line;
+        std::size_t answered = 0, errors = 0;
+        while (std::getline(answers, line)) {
+            if (line.rfind("error", 0) == 0) {
+                errors++;
+                continue;
+            }
+            std::istringstream fields(line);
+            Vertex v, end;
+            std::string distance;
+            fields >> v >> end >> distance;
+            auto [dist, prev] = G.Dijkstra(v, end);
+            assert(distance == (dist[end] == 1.0 / 0.0 ? "inf" : std::to_string(static_cast<unsigned long>(dist[end]))));
+            answered++;
+        }
+        assert(answered == queries.size() and errors == 1);
+        std::cout << "Answered " << answered << " queries" << std::endl;
+    }
+
+    // === Test Case 17: Seeded graph generators ===
+    {
+        std::cout << "=== Test 17: Graph generators ===\n";
+        std::vector<Coordinate> coordinates;
+        std::vector<Edge> grid = grid_graph(10, 20, 9, 3, &coordinates);
+        assert(grid.size() == 10 * 19 + 9 * 20 and coordinates.size() == 200);
+        assert(coordinates[21].x == 1 and coordinates[21].y == 1);
+
+        std::vector<Edge> geometric = random_geometric_graph(2000, 6, 3, &coordinates);
+        assert(geometric.size() > 4000 and geometric.size() < 8000);
+        for (const Edge& e : geometric) {
+            double length = std::hypot(coordinates[e.get_left()].x - coordinates[e.get_right()].x,
+                                       coordinates[e.get_left()].y - coordinates[e.get_right()].y);
+            assert(std::abs(e.get_weight() - length * GENERATOR_LENGTH_SCALE) <= 1);
+        }
+
+        std::vector<Edge> random = erdos_renyi_graph(1000, 4, 50, 3);
+        assert(random.size() == 2000);
+        std::vector<Edge> power_law = power_law_graph(1000, 2, 50, 3);
+        std::vector<std::size_t> degree(1000, 0);
+        for (const Edge& e : power_law) {
+            assert(e.get_left() != e.get_right());
+            degree[e.get_left()]++;
+            degree[e.get_right()]++;
+        }
+        assert(*std::max_element(degree.begin(), degree.end()) > 20);
+
+        // Same seed, same graph
+        std::vector<Edge> again = erdos_renyi_graph(1000, 4, 50, 3);
+        for (std::size_t i = 0; i < random.size(); i++) assert(random[i] == again[i]);
+        std::cout << "Geometric edges: " << geometric.size() << std::endl;
+    }
+
+    // === Test Case 18: Search instrumentation ===
+    {
+        std::cout << "=== Test 18: Search stats ===\n";
+        Histogram histogram;
+        for (std::uint64_t x = 1; x <= 1000; x++) histogram.add(x);
+        assert(histogram.count() == 1000 and histogram.max() == 1000 and histogram.mean() == 500.5);
+        assert(histogram.percentile(0.5) >= 500 * 7 / 8 and histogram.percentile(0.5) <= 500);
+        assert(histogram.percentile(1) <= 1000 and histogram.percentile(1) >= 1000 * 7 / 8);
+        Histogram other;
+        other.add(5000);
+        histogram.merge(other);
+        assert(histogram.count() == 1001 and histogram.max() == 5000);
+
+        std::vector<Edge> edges = random_tree_graph(300, 20, 8);
+        const Graph G(edges);
+        auto [dist, prev, stats] = G.TracedDijkstra(0, NO_VERTEX);
+        QueryContext ctx;
+        dijkstra(G, 0, NO_VERTEX, ctx);
+        const SearchStats& context_stats = ctx.get_stats();
+        if (STATS_ENABLED) {
+            // A full search settles everything reachable once and scans every edge from both ends
+            assert(stats.settled == G.num_vertices() and stats.pops == stats.settled);
+            assert(stats.relaxations == 2 * edges.size());
+            assert(stats.pushes == G.num_vertices() and stats.stale == 0);
+            assert(context_stats.settled == stats.settled and context_stats.decrease_keys == stats.decrease_keys);
+        }
+        else {
+            assert(stats.settled == 0 and stats.relaxations == 0 and context_stats.pops == 0);
+        }
+
+        std::istringstream in("0 5\n3 7\n");
+        std::ostringstream out;
+        QueryServer<Graph> server(G, 2);
+        serve_stream(server, in, out);
+        assert(server.get_stats().latency_ns.count() == 2);
+        std::istringstream stats_in("stats\n");
+        std::ostringstream stats_out;
+        serve_stream(server, stats_in, stats_out);
+        assert(stats_out.str().rfind("stats queries 2 ", 0) == 0);
+        // Only the whole word asks for the counters
+        std::istringstream not_stats_in("statsfoo\nstats123\n");
+        std::ostringstream not_stats_out;
+        serve_stream(server, not_stats_in, not_stats_out);
+        assert(not_stats_out.str() == "error expected '<source> <target>'\nerror expected '<source> <target>'\n");
+        std::cout << stats_out.str();
+    }
+
+    // === Test Case 19: Arena-backed bulk construction ===
+    {
+        std::cout << "=== Test 19: Arena construction ===\n";
+        std::vector<Edge> edges = random_geometric_graph(3000, 6, 4);
+        Graph bulk(edges);
+        Graph incremental;
+        incremental.reserve(3000, edges.size());
+        for (const Edge& e : edges) incremental.add_element(e);
+        assert(bulk.num_vertices() == incremental.num_vertices());
+        assert(bulk.arena_bytes() > 0);
+        for (Vertex v = 0; v < bulk.num_vertices(); v++) {
+            // The bulk build sized every list exactly
+            assert(bulk.get_adj()[v].size() == bulk.get_adj()[v].capacity());
+        }
+        auto [dist, prev] = bulk.Dijkstra(0, NO_VERTEX);
+        auto [incremental_dist, incremental_prev] = incremental.Dijkstra(0, NO_VERTEX);
+        assert(dist == incremental_dist);
+
+        // A copy outlives the original's arena and keeps growing on its own
+        Graph copy(5);
+        {
+            Graph original(edges);
+            copy = original;
+        }
+        // Assigning again replaces the arena instead of piling up the old lists in it
+        Graph grid(grid_graph(100, 100, 10, 19));
+        Graph assigned;
+        assigned = grid;
+        std::size_t once = assigned.arena_bytes();
+        for (int i = 0; i < 5; i++) assigned = grid;
+        assert(assigned.arena_bytes() == once);
+        copy.add_element(Edge(3000, 0, 1));
+        auto [copy_dist, copy_prev] = copy.Dijkstra(0, NO_VERTEX);
+        assert(copy_dist[3000] == 1 and copy_dist[2999] == dist[2999]);
+
+        UnionFind components;
+        components.reserve(10);
+        components.union_operation(2, 7);
+        components.union_operation(100000, 7);
+        assert(components.connected(2, 100000) and !components.connected(2, 3));
+        std::cout << "Arena bytes: " << bulk.arena_bytes() << std::endl;
+    }
+
+    // === Test Case 20: Dynamic weight updates ===
+    {
+        std::cout << "=== Test 20: Dynamic shortest paths ===\n";
+        std::mt19937 rng(13);
+        std::vector<Edge> edges = random_tree_graph(400, 50, 13);
+        edges.push_back(Edge(17, 17, 3));
+        Graph G(edges);
+        DynamicShortestPaths tree(G, 0);
+
+        // Raising an edge that no shortest path uses changes nothing
+        auto [dist, prev] = G.Dijkstra(0, NO_VERTEX);
+        for (const Edge& e : edges) {
+            Vertex a = e.get_left(), b = e.get_right();
+            if (prev[a] != b and prev[b] != a and a != b) {
+                assert(tree.apply({EdgeUpdate{UpdateKind::SET_WEIGHT, a, b, e.get_weight() + 10}}) == 0);
+                break;
+            }
+        }
+
+        std::size_t repaired = 0;
+        for (int batch = 0; batch < 40; batch++) {
+            std::vector<EdgeUpdate> updates;
+            for (int k = 0; k < 5; k++) {
+                Vertex v = rng() % 405, u = rng() % 400;
+                int kind = rng() % 3;
+                std::vector<Edge>& current = G.get_data();
+                const Edge& e = current[rng() % current.size()];
+                if (kind == 0) updates.push_back(EdgeUpdate{UpdateKind::SET_WEIGHT, e.get_left(), e.get_right(), 1 + rng() % 80});
+                else if (kind == 1) updates.push_back(EdgeUpdate{UpdateKind::INSERT, v, u, 1 + rng() % 80});
+                else {
+                    updates.push_back(EdgeUpdate{UpdateKind::REMOVE, e.get_left(), e.get_right(), 0});
+                    tree.apply(updates);
+                    updates.clear();
+                }
+            }
+            repaired += tree.apply(updates);
+            auto [fresh, fresh_prev] = G.Dijkstra(0, NO_VERTEX);
+            assert(tree.get_dist() == fresh);
+            const std::vector<Vertex>& tree_prev = tree.get_prev();
+            for (Vertex w = 1; w < G.num_vertices(); w++) {
+                if (fresh[w] == 1.0 / 0.0) continue;
+                // prev must be a neighbor on a shortest path
+                bool tight = false;
+                G.for_each_neighbor(w, [&](Vertex x, Weight weight) {
+                    if (x == tree_prev[w] and fresh[x] + weight == fresh[w]) tight = true;
+                });
+                assert(tight);
+            }
+        }
+        // The edge list caught up with the changes made through the neighbor lists
+        std::size_t slots = 0;
+        for (Vertex w = 0; w < G.num_vertices(); w++) slots += G.get_adj()[w].size();
+        assert(2 * G.get_data().size() == slots);
+        std::cout << "Repaired labels over 40 batches: " << repaired << std::endl;
+
+        // The same tree edge shortened and then lengthened in one batch
+        Graph H(std::vector<Edge>{Edge(0, 1, 1), Edge(1, 2, 5), Edge(0, 2, 20)});
+        DynamicShortestPaths twice(H, 0);
+        twice.apply({EdgeUpdate{UpdateKind::SET_WEIGHT, 1, 2, 2}, EdgeUpdate{UpdateKind::SET_WEIGHT, 1, 2, 50}});
+        assert(twice.get_dist()[2] == 20);
+        assert(twice.get_dist() == std::get<0>(H.Dijkstra(0, NO_VERTEX)));
+
+        // A bad update keeps the ones before it and the tree is repaired for them before the error comes out
+        bool failed = false;
+        try {
+            twice.apply({EdgeUpdate{UpdateKind::SET_WEIGHT, 0, 1, 100}, EdgeUpdate{UpdateKind::REMOVE, 2, 2, 0},
+                         EdgeUpdate{UpdateKind::SET_WEIGHT, 0, 2, 1}});
+        } catch (const std::runtime_error&) {
+            failed = true;
+        }
+        assert(failed and twice.get_dist()[1] == 70 and twice.get_dist()[2] == 20);
+        assert(twice.get_dist() == std::get<0>(H.Dijkstra(0, NO_VERTEX)) and twice.get_prev()[1] == 2);
+    }
+
+    // === Test Case 21: Customizable route planning ===
+    {
+        std::cout << "=== Test 21: Customizable route planning ===\n";
+        std::vector<Edge> edges = grid_graph(40, 50, 100, 21);
+        edges.push_back(Edge(2000, 2001, 7));  // a separate component
+        Graph G(edges);
+        CustomizableRoutePlanner crp(G, {16, 64, 256}, 4);
+        assert(crp.num_levels() == 3);
+        std::size_t limits[3] = {16, 64, 256};
+        for (std::size_t k = 0; k < crp.num_levels(); k++) {
+            // Cells respect their size limit and nest inside the cells of the next level
+            std::vector<std::size_t> size(crp.num_cells(k), 0);
+            std::vector<std::uint32_t> parent(crp.num_cells(k), static_cast<std::uint32_t>(-1));
+            for (Vertex v = 0; v < G.num_vertices(); v++) {
+                std::uint32_t c = crp.get_cell(k, v);
+                size[c]++;
+                if (k + 1 == crp.num_levels()) continue;
+                if (parent[c] == static_cast<std::uint32_t>(-1)) parent[c] = crp.get_cell(k + 1, v);
+                assert(parent[c] == crp.get_cell(k + 1, v));
+            }
+            for (std::size_t c : size) assert(c > 0 and c <= limits[k]);
+        }
+        std::mt19937 rng(21);
+        QueryContext forward, backward;
+        auto check = [&](int queries) {
+            for (int i = 0; i < queries; i++) {
+                Vertex s = rng() % 2000, t = rng() % 2000;
+                auto [dist, prev] = G.Dijkstra(s, t);
+                auto [d, path] = crp.Query(s, t, forward, backward);
+                assert(d == dist[t] and std::get<0>(crp.Query<8>(s, t)) == d);
+                assert(path.front() == s and path.back() == t);
+                double length = 0;
+                for (std::size_t j = 0; j + 1 < path.size(); j++) {
+                    Weight best = 0;
+                    bool found = false;
+                    G.for_each_neighbor(path[j], [&](Vertex w, Weight weight) {
+                        if (w == path[j + 1] and (!found or weight < best)) {
+                            best = weight;
+                            found = true;
+                        }
+                    });
+                    assert(found);
+                    length += best;
+                }
+                assert(length == d);
+            }
+        };
+        check(200);
+        assert(std::get<0>(crp.Query(0, 2001)) == 1.0 / 0.0);
+        assert(std::get<0>(crp.Query(2000, 2001)) == 7);
+
+        // New weights only need a new customization
+        for (const Edge& e : edges) {
+            if (rng() % 4 == 0) G.set_weight(e.get_left(), e.get_right(), 1 + rng() % 300);
+        }
+        crp.customize(4);
+        check(200);
+        std::cout << "Cells per level: " << crp.num_cells(0) << " " << crp.num_cells(1) << " " << crp.num_cells(2) << std::endl;
+    }
+
+    // === Test Case 22: Integer priority queues ===
+    {
+        std::cout << "=== Test 22: Integer priority queues ===\n";
+        // Keys come out in order, including lowered ones and ones pushed again at the current key
+        RadixHeap radix(10);
+        BucketQueue dial(10, 100);
+        std::vector<std::uint64_t> keys(10);
+        for (Vertex v = 0; v < 10; v++) {
+            keys[v] = 50 + (v * 37) % 50;
+            radix.push(v, keys[v]);
+            dial.push(v, keys[v]);
+        }
+        keys[7] = 51;
+        radix.decrease_key(7, 51);
+        dial.decrease_key(7, 51);
+        std::uint64_t radix_last = 0, dial_last = 0;
+        bool again = true;
+        while (!radix.empty()) {
+            Vertex r = radix.pop(), d = dial.pop();
+            assert(keys[r] >= radix_last and keys[d] >= dial_last and keys[r] == keys[d]);
+            radix_last = keys[r];
+            dial_last = keys[d];
+            if (again and !radix.contains(9)) {
+                keys[9] = radix_last;
+                radix.push(9, radix_last);
+                dial.push(9, dial_last);
+                again = false;
+            }
+        }
+        assert(dial.empty());
+
+        std::vector<Edge> edges = grid_graph(30, 30, 9, 22);
+        std::mt19937 rng(22);
+        for (int i = 0; i < 300; i++) edges.push_back(Edge(rng() % 900, rng() % 900, 1 + rng() % 9));
+        Graph G(edges);
+        for (Vertex s : {0, 450, 899}) {
+            auto [dist, prev] = G.Dijkstra(s, NO_VERTEX);
+            for (QueueBackend backend : {QueueBackend::HEAP, QueueBackend::RADIX_HEAP, QueueBackend::DIAL}) {
+                auto [exact, exact_prev] = G.IntegerDijkstra(s, NO_VERTEX, backend);
+                for (Vertex v = 0; v < G.num_vertices(); v++) assert(double(exact[v]) == dist[v]);
+            }
+        }
+        // One queue serves many searches
+        RadixHeap shared(G.num_vertices());
+        for (Vertex s = 0; s < 20; s++) {
+            SearchStats stats;
+            auto [exact, exact_prev] = integer_dijkstra(G, s, 899, shared, stats);
+            assert(double(exact[899]) == std::get<0>(G.Dijkstra(s, 899))[899]);
+        }
+
+        // Distances that do not fit saturate to infinity instead of wrapping around
+        Graph far(std::vector<Edge>{Edge(0, 1, INFINITE_DISTANCE / 2), Edge(1, 2, INFINITE_DISTANCE / 2 + 5), Edge(3, 4, 1)});
+        auto [exact, exact_prev] = far.IntegerDijkstra(0);
+        assert(exact[1] == INFINITE_DISTANCE / 2 and exact[2] == INFINITE_DISTANCE and exact[3] == INFINITE_DISTANCE);
+        std::cout << "Queues agree with Dijkstra" << std::endl;
+    }
+
+    // === Test Case 23: Vertex reordering ===
+    {
+        std::cout << "=== Test 23: Vertex reordering ===\n";
+        std::vector<Coordinate> grid_coordinates;
+        std::vector<Edge> grid = grid_graph(40, 40, 20, 23, &grid_coordinates);
+        // Scramble the ids first, as if the graph came from a file in arbitrary order
+        VertexPermutation scramble = random_order(1600 + 2, 23);
+        grid.push_back(Edge(1600, 1601, 4));
+        grid_coordinates.resize(1602, Coordinate{0, 0});
+        std::vector<Coordinate> coordinates = scramble.internal_labels(grid_coordinates);
+        Graph G(scramble.relabel(grid), 1602);
+
+        // Mean id distance between the ends of an edge
+        auto spread = [](Graph& H) {
+            double total = 0;
+            for (const Edge& e : H.get_data()) total += double(std::max(e.get_left(), e.get_right()) - std::min(e.get_left(), e.get_right()));
+            return total / H.get_data().size();
+        };
+        double scrambled = spread(G);
+        std::vector<Vertex> sources = {0, 77, 1601};
+        for (int kind = 0; kind < 3; kind++) {
+            VertexPermutation order = kind == 0 ? bfs_order(G) : kind == 1 ? reverse_cuthill_mckee_order(G) : hilbert_order(coordinates);
+            assert(order.size() == G.num_vertices());
+            Graph R = reorder(G, order);
+            assert(R.num_vertices() == G.num_vertices());
+            assert(spread(R) * 10 < scrambled);
+            for (Vertex s : sources) {
+                auto [dist, prev] = G.Dijkstra(s, NO_VERTEX);
+                auto [internal_dist, internal_prev] = R.Dijkstra(order.to_internal(s), NO_VERTEX);
+                assert(order.external_labels(internal_dist) == dist);
+                std::vector<Vertex> tree = order.external_tree(internal_prev);
+                for (Vertex v = 0; v < G.num_vertices(); v++) {
+                    assert(order.to_internal(order.to_external(v)) == v);
+                    if (tree[v] != NO_VERTEX and v != s) assert(G.connected(v, tree[v]) and dist[tree[v]] < dist[v]);
+                }
+                Vertex t = order.to_internal(5);
+                auto [d, path] = R.BidirectionalDijkstra(order.to_internal(s), t);
+                if (d != 1.0 / 0.0) assert(order.external_path(path).back() == 5);
+            }
+        }
+        std::cout << "Mean edge id gap before reordering: " << scrambled << std::endl;
+    }
+
+    // === Test Case 24: SIMD relaxation ===
+    {
+        std::cout << "=== Test 24: SIMD relaxation ===\n";
+        std::mt19937 rng(24);
+        std::vector<double> dist(1000);
+        for (double& d : dist) d = rng() % 5 == 0 ? 1.0 / 0.0 : double(rng() % 100000);
+        for (std::size_t count : {0, 1, 3, 4, 7, 8, 9, 17, 64, 333}) {
+            std::vector<std::uint32_t> targets(count), weights(count);
+            for (std::size_t i = 0; i < count; i++) {
+                targets[i] = rng() % 1000;
+                weights[i] = i % 5 == 0 ? 3000000000u + rng() % 1000 : rng() % 50000;  // some above 2^31
+            }
+            std::vector<std::uint32_t> expected(count), got(count);
+            std::size_t want = relax_scalar(targets.data(), weights.data(), count, 40000, dist.data(), expected.data());
+            for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512}) {
+                std::size_t found = relax_kernel(level)(targets.data(), weights.data(), count, 40000, dist.data(), got.data());
+                assert(found == want);
+                for (std::size_t k = 0; k < found; k++) assert(got[k] == expected[k]);
+            }
+        }
+
+        // High-degree hubs, where whole rows go through the vector kernel
+        CSRGraph C(power_law_graph(3000, 4, 1000, 24));
+        for (Vertex s : {0, 1, 1234}) {
+            auto [dist_ref, prev_ref] = C.Dijkstra(s, NO_VERTEX);
+            for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512}) {
+                auto [simd_dist, simd_prev] = simd_dijkstra(C, s, NO_VERTEX, level);
+                assert(simd_dist == dist_ref);
+            }
+        }
+        std::cout << "Best SIMD level on this machine: " << simd_level_name(best_simd_level()) << std::endl;
+    }
+
+    // === Test Case 25: Negative weights ===
+    {
+        std::cout << "=== Test 25: Bellman-Ford and Johnson ===\n";
+        // 0 -> 2 -> 1 -> 3 beats the direct arc to 1
+        SignedGraph small({{0, 1, 4}, {0, 2, 5}, {2, 1, -3}, {1, 3, 2}}, 5);
+        BellmanFordResult r = bellman_ford(small, 0, 1);
+        assert(r.negative_cycle.empty());
+        assert(r.dist[1] == 2 and r.dist[3] == 4 and r.prev[1] == 2 and r.prev[3] == 1);
+        assert(r.dist[4] == SIGNED_INFINITE_DISTANCE and r.prev[4] == NO_VERTEX);
+
+        // Arc weights c + p(u) - p(v) with c >= 0: plenty of negative arcs but no negative cycle
+        std::mt19937 rng(25);
+        std::size_t n = 150;
+        std::vector<SignedWeight> p(n);
+        for (SignedWeight& x : p) x = rng() % 200;
+        std::vector<SignedEdge> arcs;
+        for (int i = 0; i < 900; i++) {
+            Vertex u = rng() % n, v = rng() % n;
+            arcs.push_back(SignedEdge{u, v, SignedWeight(rng() % 30) + p[u] - p[v]});
+        }
+        SignedGraph G(arcs, n);
+        // Floyd-Warshall reference
+        std::vector<SignedWeight> reference(n * n, SIGNED_INFINITE_DISTANCE);
+        for (Vertex v = 0; v < n; v++) reference[v * n + v] = 0;
+        for (const SignedEdge& a : arcs) reference[a.from * n + a.to] = std::min(reference[a.from * n + a.to], a.weight);
+        for (Vertex k = 0; k < n; k++) {
+            for (Vertex i = 0; i < n; i++) {
+                if (reference[i * n + k] == SIGNED_INFINITE_DISTANCE) continue;
+                for (Vertex j = 0; j < n; j++) {
+                    if (reference[k * n + j] == SIGNED_INFINITE_DISTANCE) continue;
+                    reference[i * n + j] = std::min(reference[i * n + j], reference[i * n + k] + reference[k * n + j]);
+                }
+            }
+        }
+        ThreadPool pool(3);
+        for (Vertex s : {0, 7, 149}) {
+            BellmanFordResult result = bellman_ford(G, s, pool);
+            assert(result.negative_cycle.empty() and result.rounds < n);
+            for (Vertex v = 0; v < n; v++) {
+                assert(result.dist[v] == reference[s * n + v]);
+                if (v == s or result.prev[v] == NO_VERTEX) continue;
+                bool tight = false;
+                G.for_each_arc(result.prev[v], [&](Vertex w, SignedWeight weight) {
+                    if (w == v and result.dist[result.prev[v]] + weight == result.dist[v]) tight = true;
+                });
+                assert(tight);
+            }
+        }
+        JohnsonGraph J(G, pool);
+        assert(!J.has_negative_cycle());
+        for (Vertex u = 0; u < n; u++) {
+            J.for_each_neighbor(u, [&](Vertex, Weight weight) { assert(static_cast<SignedWeight>(weight) >= 0); });
+        }
+        std::vector<SignedWeight> all(n * n);
+        J.all_pairs(all.data(), pool);
+        assert(all == reference);
+        std::vector<SignedWeight> from_seven = J.distances_from(7, QueueBackend::HEAP);
+        assert(std::equal(from_seven.begin(), from_seven.end(), reference.begin() + 7 * n));
+        auto [reweighted, prev] = dijkstra(J, 7, NO_VERTEX);
+        // Infinity is checked before the conversion to Weight, which it does not fit
+        if (reweighted[30] == 1.0 / 0.0) assert(reference[7 * n + 30] == SIGNED_INFINITE_DISTANCE);
+        else assert(J.original_distance(7, 30, Weight(reweighted[30])) == reference[7 * n + 30]);
+
+        // A cycle of weight -1 through 1 and 2; 3 hangs off it, 4 only leads into it, 5 is cut off
+        SignedGraph cyclic({{0, 1, 1}, {1, 2, -2}, {2, 1, 1}, {2, 3, 1}, {4, 0, 1}, {5, 5, -1}}, 7);
+        auto valid_cycle = [](const SignedGraph& H, const std::vector<Vertex>& cycle) {
+            SignedWeight total = 0;
+            for (std::size_t i = 0; i < cycle.size(); i++) {
+                Vertex from = cycle[i], to = cycle[(i + 1) % cycle.size()];
+                SignedWeight best = SIGNED_INFINITE_DISTANCE;
+                H.for_each_arc(from, [&](Vertex w, SignedWeight weight) {
+                    if (w == to) best = std::min(best, weight);
+                });
+                if (best == SIGNED_INFINITE_DISTANCE) return false;
+                total += best;
+            }
+            return !cycle.empty() and total < 0;
+        };
+        r = bellman_ford(cyclic, 0, pool);
+        assert(valid_cycle(cyclic, r.negative_cycle));
+        assert(r.dist[0] == 0 and r.dist[4] == SIGNED_INFINITE_DISTANCE and r.dist[5] == SIGNED_INFINITE_DISTANCE);
+        assert(r.dist[1] == NEGATIVE_INFINITE_DISTANCE and r.dist[2] == NEGATIVE_INFINITE_DISTANCE and r.dist[3] == NEGATIVE_INFINITE_DISTANCE);
+        r = bellman_ford(cyclic, 5, pool);
+        assert(r.negative_cycle == std::vector<Vertex>{5} and r.dist[5] == NEGATIVE_INFINITE_DISTANCE);
+        r = bellman_ford(cyclic, 6, pool);
+        assert(r.negative_cycle.empty() and r.dist[6] == 0 and r.rounds == 1);
+        JohnsonGraph K(cyclic, pool);
+        assert(K.has_negative_cycle() and valid_cycle(cyclic, K.get_negative_cycle()));
+        bool threw = false;
+        try { K.distances_from(0); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+
+        // A negative cycle planted in the random graph
+        arcs.push_back(SignedEdge{3, 4, -1000});
+        arcs.push_back(SignedEdge{4, 3, 500});
+        SignedGraph planted(arcs, n);
+        JohnsonGraph P(planted, pool);
+        assert(valid_cycle(planted, P.get_negative_cycle()));
+        std::cout << "Johnson rounds: " << J.get_rounds() << ", negative cycle of " << P.get_negative_cycle().size() << " vertices" << std::endl;
+    }
+
+    // === Test Case 26: Directed graphs ===
+    {
+        std::cout << "=== Test 26: Directed graphs ===\n";
+        // A one-way triangle 0 -> 1 -> 2 -> 0 with a long shortcut 0 -> 2
+        DirectedGraph T({{0, 1, 1}, {1, 2, 1}, {2, 0, 1}, {0, 2, 5}});
+        assert(T.num_vertices() == 3 and T.num_arcs() == 4 and T.out_degree(0) == 2 and T.in_degree(0) == 1);
+        auto [dist, prev] = T.Dijkstra(0, NO_VERTEX);
+        assert(dist[2] == 2 and prev[2] == 1);
+        auto [back, next] = T.ReverseDijkstra(0);
+        assert(back[1] == 2 and back[2] == 1 and next[1] == 2);
+        auto [length, path] = T.BidirectionalDijkstra(2, 1);
+        assert(length == 2 and path == std::vector<Vertex>({2, 0, 1}));
+
+        std::mt19937 rng(26);
+        std::size_t n = 400;
+        std::vector<DirectedEdge> arcs;
+        for (int i = 0; i < 2000; i++) arcs.push_back(DirectedEdge{rng() % n, rng() % n, 1 + rng() % 50});
+        for (Vertex v = 0; v < 20; v++) arcs.push_back(DirectedEdge{v, 100 + v, 1 + rng() % 50});  // a few hubs
+        DirectedGraph D(arcs, n + 1);
+        assert(D.num_vertices() == n + 1 and D.num_arcs() == arcs.size());
+        std::size_t in_total = 0;
+        for (Vertex v = 0; v < D.num_vertices(); v++) {
+            in_total += D.in_degree(v);
+            D.for_each_in_neighbor(v, [&](Vertex u, Weight weight) {
+                bool found = false;
+                D.for_each_neighbor(u, [&](Vertex w, Weight w_weight) { found = found or (w == v and w_weight == weight); });
+                assert(found);
+            });
+        }
+        assert(in_total == arcs.size());
+
+        QueryContext forward, backward;
+        for (Vertex s : {0, 17, 399}) {
+            auto [forward_dist, forward_prev] = D.Dijkstra(s, NO_VERTEX);
+            auto [simd_dist, simd_prev] = simd_dijkstra(D, s);
+            assert(simd_dist == forward_dist);
+            for (Vertex t = 0; t < D.num_vertices(); t += 7) {
+                auto [to_t, next_t] = D.ReverseDijkstra(t);
+                assert(to_t[s] == forward_dist[t]);
+                auto [d, p] = bidirectional_dijkstra(D, s, t, forward, backward);
+                assert(d == forward_dist[t]);
+                if (d != 1.0 / 0.0) assert(p.front() == s and p.back() == t);
+            }
+        }
+
+        // The Dijkstra-based matrix only follows out-arcs, so it stays exact on one-way streets. The engines
+        // built on symmetric distances (ContractionHierarchy, CustomizableRoutePlanner, Landmarks) reject a
+        // DirectedGraph at compile time instead.
+        std::vector<Vertex> matrix_sources = {0, 17, 399}, matrix_targets = {1, 2, 150, 399};
+        std::vector<double> directed_table(matrix_sources.size() * matrix_targets.size());
+        ThreadPool matrix_pool(2);
+        distance_matrix(D, matrix_sources, matrix_targets, directed_table.data(), matrix_pool);
+        for (std::size_t i = 0; i < matrix_sources.size(); i++) {
+            std::vector<double> expected = std::get<0>(D.Dijkstra(matrix_sources[i], NO_VERTEX));
+            for (std::size_t j = 0; j < matrix_targets.size(); j++) {
+                assert(directed_table[i * matrix_targets.size() + j] == expected[matrix_targets[j]]);
+            }
+        }
+
+        // Delta-stepping builds prev from in-arcs, also across zero-weight arcs
+        std::vector<DirectedEdge> zero_arcs = arcs;
+        for (Vertex v = 0; v < 30; v++) zero_arcs.push_back(DirectedEdge{rng() % n, rng() % n, 0});
+        DirectedGraph Z(zero_arcs, n + 1);
+        for (Vertex s : {0, 17}) {
+            auto [expected, expected_prev] = Z.Dijkstra(s, NO_VERTEX);
+            auto [stepped, stepped_prev] = delta_stepping(Z, s, matrix_pool, 8);
+            assert(stepped == expected and stepped_prev[s] == s);
+            for (Vertex w = 0; w < Z.num_vertices(); w++) {
+                if (w == s) continue;
+                if (stepped[w] == 1.0 / 0.0) {
+                    assert(stepped_prev[w] == NO_VERTEX);
+                    continue;
+                }
+                bool tight = false;
+                Z.for_each_in_neighbor(w, [&](Vertex u, Weight weight) { tight = tight or (u == stepped_prev[w] and stepped[u] + weight == stepped[w]); });
+                assert(tight);
+                // Following prev reaches the source without a cycle
+                Vertex x = w;
+                for (std::size_t steps = 0; x != s; steps++) {
+                    assert(steps < Z.num_vertices());
+                    x = stepped_prev[x];
+                }
+            }
+        }
+
+        // An undirected graph as arcs both ways gives the same distances
+        Graph U(grid_graph(10, 10, 30, 26));
+        DirectedGraph B(U);
+        assert(B.num_arcs() == 2 * U.get_data().size());
+        auto [undirected_dist, undirected_prev] = U.Dijkstra(3, NO_VERTEX);
+        auto [both_ways, both_prev] = B.Dijkstra(3, NO_VERTEX);
+        assert(both_ways == undirected_dist);
+
+        // DIMACS arcs keep their direction when loaded as a directed graph
+        std::string path_name = "test_directed.gr";
+        std::ofstream(path_name) << "p sp 3 3\na 1 2 4\na 2 3 4\na 3 1 4\n";
+        LoadStats stats;
+        DirectedGraph L = load_directed_graph(path_name, EdgeListFormat::DIMACS, &stats);
+        std::remove(path_name.c_str());
+        assert(stats.edges == 3 and L.num_arcs() == 3);
+        auto [loaded, loaded_prev] = L.Dijkstra(2, NO_VERTEX);
+        assert(loaded[1] == 8 and loaded[3] == 4);
+        std::cout << "Directed graph: " << D.num_arcs() << " arcs in " << D.memory_bytes() << " bytes" << std::endl;
+    }
+
+    // === Test Case 27: All-pairs shortest paths ===
+    {
+        std::cout << "=== Test 27: All-pairs shortest paths ===\n";
+        assert(choose_all_pairs_method(300, 1200) == AllPairsMethod::FLOYD_WARSHALL);
+        assert(choose_all_pairs_method(5000, 20000) == AllPairsMethod::DIJKSTRA);
+        assert(choose_all_pairs_method(5000, 5000 * 500) == AllPairsMethod::FLOYD_WARSHALL);
+
+        // 300 vertices: the last tile row and column are partial; a few vertices only have arcs out or none at all
+        std::mt19937 rng(27);
+        std::size_t n = 300;
+        std::vector<DirectedEdge> arcs;
+        for (int i = 0; i < 1500; i++) arcs.push_back(DirectedEdge{rng() % (n - 10), rng() % (n - 10), 1 + rng() % 1000});
+        for (Vertex v = n - 10; v < n - 5; v++) arcs.push_back(DirectedEdge{v, rng() % n, 1 + rng() % 1000});
+        DirectedGraph D(arcs, n);
+        ThreadPool pool(3);
+        std::vector<std::uint32_t> by_dijkstra(n * n), by_floyd(n * n);
+        all_pairs(D, by_dijkstra.data(), pool, AllPairsMethod::DIJKSTRA);
+        all_pairs(D, by_floyd.data(), pool, AllPairsMethod::FLOYD_WARSHALL);
+        assert(by_dijkstra == by_floyd);
+        for (Vertex s : {0, 5, 295}) {
+            auto [dist, prev] = D.Dijkstra(s, NO_VERTEX);
+            for (Vertex t = 0; t < n; t++) {
+                assert(by_floyd[s * n + t] == (dist[t] == 1.0 / 0.0 ? TABLE_INFINITY : std::uint32_t(dist[t])));
+            }
+        }
+        assert(by_floyd[(n - 1) * n] == TABLE_INFINITY and by_floyd[(n - 1) * n + n - 1] == 0);
+
+        // Every vector level gives the same table, here on whole tiles only
+        CSRGraph C(grid_graph(16, 8, 50, 27));
+        std::vector<std::uint32_t> expected = all_pairs(C, AllPairsMethod::DIJKSTRA, 1);
+        for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512}) {
+            std::size_t m = C.num_vertices();
+            std::vector<std::uint32_t> table(m * m, TABLE_INFINITY);
+            for (Vertex u = 0; u < m; u++) {
+                table[u * m + u] = 0;
+                C.for_each_neighbor(u, [&](Vertex w, Weight weight) { table[u * m + w] = std::min<std::uint32_t>(table[u * m + w], weight); });
+            }
+            floyd_warshall(table.data(), m, pool, level);
+            assert(table == expected);
+        }
+
+        // Tables on disk, written from memory or computed in place, read back through a mapping
+        std::string written = "test_table.bin", computed = "test_table_direct.bin";
+        write_distance_table(written, by_floyd.data(), n);
+        all_pairs_file(D, computed, pool);
+        {
+            MappedDistanceTable from_memory(written), in_place(computed);
+            assert(from_memory.num_vertices() == n and in_place.num_vertices() == n);
+            for (Vertex s = 0; s < n; s += 17) {
+                assert(std::equal(in_place.row(s), in_place.row(s) + n, by_floyd.begin() + s * n));
+                assert(from_memory.get(s, 3) == by_floyd[s * n + 3]);
+            }
+        }
+        // A header claiming more entries than the file holds is rejected
+        for (std::uint64_t claimed : {std::uint64_t(n + 1), std::uint64_t(1) << 33}) {
+            write_distance_table(written, by_floyd.data(), n);
+            {
+                std::fstream file(written, std::ios::binary | std::ios::in | std::ios::out);
+                file.seekp(offsetof(TableFileHeader, num_vertices));
+                file.write(reinterpret_cast<const char*>(&claimed), sizeof(claimed));
+            }
+            bool rejected = false;
+            try {
+                MappedDistanceTable table(written);
+            } catch (const std::runtime_error&) {
+                rejected = true;
+            }
+            assert(rejected);
+        }
+        std::remove(written.c_str());
+        std::remove(computed.c_str());
+        std::cout << "Distance 0 -> 5: " << by_floyd[5] << std::endl;
+    }
+
+    // === Test Case 28: Minimum spanning forests ===
+    {
+        std::cout << "=== Test 28: Minimum spanning forests ===\n";
+        // Threads uniting random pairs agree with the sequential union-find
+        std::size_t n = 5000;
+        std::mt19937 rng(28);
+        std::vector<std::pair<Vertex, Vertex>> pairs(6000);
+        for (auto& p : pairs) p = {rng() % n, rng() % n};
+        ConcurrentUnionFind shared(n);
+        std::atomic<std::size_t> merges(0);
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < 4; t++) {
+            workers.emplace_back([&, t] {
+                for (std::size_t i = t; i < pairs.size(); i += 4) merges += shared.unite(pairs[i].first, pairs[i].second);
+            });
+        }
+        for (std::thread& worker : workers) worker.join();
+        UnionFind sequential(n);
+        std::size_t sequential_merges = 0;
+        for (auto& p : pairs) {
+            sequential_merges += sequential.find_operation(p.first) != sequential.find_operation(p.second);
+            sequential.union_operation(p.first, p.second);
+        }
+        assert(merges == sequential_merges);
+        for (Vertex v = 0; v < n; v += 7) assert(shared.connected(v, 0) == sequential.connected(v, 0));
+
+        // A square with one diagonal: the three lightest edges that avoid a cycle
+        std::vector<Edge> square = {Edge(0, 1, 1), Edge(1, 2, 2), Edge(2, 3, 4), Edge(3, 0, 3), Edge(0, 2, 1)};
+        ThreadPool pool(3);
+        for (SpanningForestMethod method : {SpanningForestMethod::KRUSKAL, SpanningForestMethod::FILTER_KRUSKAL, SpanningForestMethod::BORUVKA}) {
+            SpanningForest forest = minimum_spanning_forest(square, 5, pool, method);
+            assert(forest.total_weight == 5 and forest.edges.size() == 3 and forest.components == 2);
+        }
+
+        // Many ties, self loops, parallel edges and several components; large enough for filter-Kruskal to split
+        std::vector<Edge> edges;
+        for (int i = 0; i < 60000; i++) {
+            Vertex v = rng() % (n - 100), u = rng() % 4 == 0 ? v : rng() % (n - 100);
+            if (i % 3 == 0) u = v - v % 50 + rng() % 50;  // dense clusters of 50
+            edges.push_back(Edge(v, u, 1 + rng() % (i % 2 ? 5 : 100000)));
+        }
+        Graph G(edges, n);
+        Weight expected = 0;
+        std::size_t components = 0;
+        for (unsigned threads : {1u, 3u}) {
+            ThreadPool workers_pool(threads);
+            for (SpanningForestMethod method : {SpanningForestMethod::KRUSKAL, SpanningForestMethod::FILTER_KRUSKAL, SpanningForestMethod::BORUVKA}) {
+                SpanningForest forest = minimum_spanning_forest(G.get_data(), n, workers_pool, method);
+                if (expected == 0) {
+                    expected = forest.total_weight;
+                    components = forest.components;
+                }
+                assert(forest.total_weight == expected and forest.components == components);
+                // A forest (no cycles) that spans every component of G
+                UnionFind trees(n);
+                Weight total = 0;
+                for (const Edge& e : forest.edges) {
+                    assert(trees.find_operation(e.get_left()) != trees.find_operation(e.get_right()));
+                    trees.union_operation(e.get_left(), e.get_right());
+                    total += e.get_weight();
+                }
+                assert(total == forest.total_weight);
+                for (const Edge& e : edges) assert(trees.connected(e.get_left(), e.get_right()));
+            }
+        }
+        SpanningForest forest = minimum_spanning_forest(G, SpanningForestMethod::BORUVKA, 2);
+        assert(forest.total_weight == expected);
+        std::cout << "Minimum spanning forest: " << forest.components << " trees, weight " << forest.total_weight << std::endl;
+    }
+
     std::cout << "All tests done." << std::endl;
     return 0;
 }
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for fork-join loops. The calling thread takes part as thread 0, so a
+// pool of size 1 runs everything inline. Thread indices are stable, which lets callers keep one
+// workspace per thread.
+class ThreadPool {
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable finished;
+        std::function<void(unsigned)> job;
+        std::size_t generation = 0;
+        unsigned running = 0;
+        bool stopping = false;
+
+        void work(unsigned index) {
+            std::size_t seen = 0;
+            while (true) {
+                std::function<void(unsigned)>* current;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&] { return stopping or generation != seen; });
+                    if (stopping) return;
+                    seen = generation;
+                    current = &job;
+                }
+                (*current)(index);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (--running == 0) finished.notify_one();
+                }
+            }
+        }
+
+    public:
+        // threads == 0 uses one thread per hardware core
+        ThreadPool(unsigned threads = 0) {
+            if (threads == 0) threads = std::thread::hardware_concurrency();
+            if (threads == 0) threads = 1;
+            for (unsigned i = 1; i < threads; i++) {
+                workers.emplace_back(&ThreadPool::work, this, i);
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& worker : workers) worker.join();
+        }
+
+        unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+        // Runs f(thread_index) once on every thread and returns when all of them are done
+        void run(const std::function<void(unsigned)>& f) {
+            if (workers.empty()) {
+                f(0);
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job = f;
+                running = static_cast<unsigned>(workers.size());
+                generation++;
+            }
+            wake.notify_all();
+            f(0);
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&] { return running == 0; });
+        }
+
+        // Calls f(i, thread_index) for every i in [begin, end). Threads claim blocks of 'grain' indices from a
+        // shared counter, so uneven iterations still balance.
+        template <typename FUNCTION>
+        void parallel_for(std::size_t begin, std::size_t end, FUNCTION&& f, std::size_t grain = 64) {
+            if (begin >= end) return;
+            if (grain == 0) grain = 1;
+            std::atomic<std::size_t> next(begin);
+            run([&](unsigned thread) {
+                while (true) {
+                    std::size_t first = next.fetch_add(grain);
+                    if (first >= end) break;
+                    std::size_t last = std::min(end, first + grain);
+                    for (std::size_t i = first; i < last; i++) f(i, thread);
+                }
+            });
+        }
+};
@@ -1,9 +1,25 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 using Vertex = unsigned long;
 
 class UnionFind {
     private:
         std::vector<int> union_data;
         bool empty;
+
+        // New vertices start as singletons; one resize instead of a push_back per missing id
+        void grow_to(std::size_t size) {
+            if (size > union_data.size()) union_data.resize(size, -1);
+        }
+
     public:
         UnionFind() : empty(true) {}
         UnionFind(int size) : union_data(size, -1), empty(false ? size <= 0 : true) {}
@@ -12,16 +28,7 @@ class UnionFind {
             if (empty) {
                 empty = false;
             }
-            if (v >= union_data.size()) {
-                while (union_data.size() <= v) {
-                    union_data.push_back(-1);
-                }
-            }
-            if (u >= union_data.size()) {
-                while (union_data.size() <= u) {
-                    union_data.push_back(-1);
-                }
-            }
+            grow_to(std::max(v, u) + 1);
             Vertex v_index = find_operation(v);
             Vertex u_index = find_operation(u);
             if (v_index == u_index) return;
@@ -36,11 +43,7 @@ class UnionFind {
         }
 
         Vertex find_operation(Vertex v) {
-            if (v >= union_data.size()) {
-                while (union_data.size() <= v) {
-                    union_data.push_back(-1);
-                }
-            }
+            grow_to(v + 1);
             if (union_data[v] < 0) {
                 return v;
             }
@@ -49,6 +52,26 @@ class UnionFind {
             }
         }
 
+        // Makes room for vertices 0 .. size-1 up front
+        void reserve(std::size_t size) {
+            union_data.reserve(size);
+            grow_to(size);
+        }
+
+        // Read-only find for concurrent readers: no path compression and no growth, so any number of threads can
+        // call it while nobody calls union_operation. Vertices never seen are their own root.
+        Vertex find_root(Vertex v) const {
+            if (v >= union_data.size()) return v;
+            while (union_data[v] >= 0) {
+                v = union_data[v];
+            }
+            return v;
+        }
+
+        bool connected(Vertex v, Vertex u) const {
+            return find_root(v) == find_root(u);
+        }
+
         void print_data() {
             for (int i = 0; i < union_data.size(); i++) {
                 std::cout << "(" << i << ", " << union_data[i] << ") ";
@@ -75,4 +98,76 @@ class UnionFind {
 std::ostream& operator<<(std::ostream& os, UnionFind union_set) {
     os << union_set.get_string();
     return os;
-}
\ No newline at end of file
+}
+
+// A union-find that any number of threads can use at once without locks. Each element is one 64-bit word
+// holding its parent (low 56 bits) and rank (high 8 bits), changed only by compare-and-swap:
+// - unite links the root of lower (rank, id) under the other one with a single CAS on the lower root's word,
+//   which fails, and is retried, if that root was linked or ranked up meanwhile. Ranks only grow and a
+//   linked root's rank is frozen, so (rank, id) strictly increases along parent pointers and no thread can
+//   ever close a cycle. On a rank tie the new root's rank is raised by another CAS, which may lose the race
+//   harmlessly.
+// - find halves the path as it walks it, each step a CAS that only ever moves a pointer closer to the root.
+class ConcurrentUnionFind {
+    private:
+        static constexpr std::uint64_t PARENT_MASK = (std::uint64_t(1) << 56) - 1;
+        std::vector<std::atomic<std::uint64_t>> data;
+
+        static Vertex parent_of(std::uint64_t word) { return static_cast<Vertex>(word & PARENT_MASK); }
+        static std::uint64_t rank_of(std::uint64_t word) { return word >> 56; }
+        static std::uint64_t make(Vertex parent, std::uint64_t rank) { return (rank << 56) | parent; }
+
+    public:
+        ConcurrentUnionFind(std::size_t size = 0) : data(size) {
+            if (size > PARENT_MASK) throw std::runtime_error("Too many elements for a concurrent union-find");
+            for (std::size_t v = 0; v < size; v++) data[v].store(make(v, 0), std::memory_order_relaxed);
+        }
+
+        std::size_t size() const { return data.size(); }
+
+        Vertex find(Vertex v) {
+            while (true) {
+                std::uint64_t word = data[v].load(std::memory_order_acquire);
+                Vertex parent = parent_of(word);
+                if (parent == v) return v;
+                std::uint64_t parent_word = data[parent].load(std::memory_order_acquire);
+                Vertex grandparent = parent_of(parent_word);
+                if (grandparent != parent) {
+                    data[v].compare_exchange_weak(word, make(grandparent, rank_of(word)), std::memory_order_release, std::memory_order_relaxed);
+                }
+                v = parent;
+            }
+        }
+
+        // Joins the sets of v and u; false if they were one set already
+        bool unite(Vertex v, Vertex u) {
+            while (true) {
+                Vertex rv = find(v), ru = find(u);
+                if (rv == ru) return false;
+                std::uint64_t word_v = data[rv].load(std::memory_order_acquire);
+                std::uint64_t word_u = data[ru].load(std::memory_order_acquire);
+                // One of them stopped being a root since find: start over
+                if (parent_of(word_v) != rv or parent_of(word_u) != ru) continue;
+                std::uint64_t rank_v = rank_of(word_v), rank_u = rank_of(word_u);
+                if (rank_v > rank_u or (rank_v == rank_u and rv > ru)) {
+                    std::swap(rv, ru);
+                    std::swap(word_v, word_u);
+                    std::swap(rank_v, rank_u);
+                }
+                // rv is the lower one and goes under ru
+                if (!data[rv].compare_exchange_strong(word_v, make(ru, rank_v), std::memory_order_acq_rel)) continue;
+                if (rank_v == rank_u) data[ru].compare_exchange_strong(word_u, make(ru, rank_u + 1), std::memory_order_acq_rel);
+                return true;
+            }
+        }
+
+        // Safe while other threads unite: if v's root is still a root after u's root was found, both were roots
+        // at that moment, so the sets were apart then
+        bool connected(Vertex v, Vertex u) {
+            while (true) {
+                Vertex rv = find(v), ru = find(u);
+                if (rv == ru) return true;
+                if (parent_of(data[rv].load(std::memory_order_acquire)) == rv) return false;
+            }
+        }
+};
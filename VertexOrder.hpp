@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "Coordinate.hpp"
+#include "Graph.hpp"
+
+// A renumbering of the vertices. External ids are the ones the caller knows, internal ids the ones of the
+// reordered graph; both directions are kept so queries can be asked and answered in external ids. Ids
+// outside the permutation (e.g. NO_VERTEX) map to themselves.
+class VertexPermutation {
+    private:
+        std::vector<Vertex> internal_of;
+        std::vector<Vertex> external_of;
+
+    public:
+        VertexPermutation() {}
+
+        // order[i] is the external id that becomes internal id i
+        explicit VertexPermutation(std::vector<Vertex> order) : internal_of(order.size(), NO_VERTEX), external_of(std::move(order)) {
+            for (Vertex i = 0; i < external_of.size(); i++) {
+                Vertex v = external_of[i];
+                if (v >= internal_of.size() or internal_of[v] != NO_VERTEX) {
+                    throw std::runtime_error("Vertex order is not a permutation");
+                }
+                internal_of[v] = i;
+            }
+        }
+
+        std::size_t size() const { return external_of.size(); }
+
+        Vertex to_internal(Vertex external) const { return external < internal_of.size() ? internal_of[external] : external; }
+        Vertex to_external(Vertex internal) const { return internal < external_of.size() ? external_of[internal] : internal; }
+
+        // The same edges between the internal ids
+        std::vector<Edge> relabel(const std::vector<Edge>& edges) const {
+            std::vector<Edge> relabelled;
+            relabelled.reserve(edges.size());
+            for (const Edge& e : edges) {
+                relabelled.push_back(Edge(to_internal(e.get_left()), to_internal(e.get_right()), e.get_weight()));
+            }
+            return relabelled;
+        }
+
+        // Per-vertex values indexed by external id, from values indexed by internal id (e.g. a dist array)
+        template <typename T>
+        std::vector<T> external_labels(const std::vector<T>& internal) const {
+            if (internal.size() != size()) throw std::runtime_error("Labels do not match the permutation");
+            std::vector<T> external(internal.size());
+            for (Vertex i = 0; i < internal.size(); i++) external[to_external(i)] = internal[i];
+            return external;
+        }
+
+        // Per-vertex values indexed by internal id, from values indexed by external id (e.g. coordinates)
+        template <typename T>
+        std::vector<T> internal_labels(const std::vector<T>& external) const {
+            if (external.size() != size()) throw std::runtime_error("Labels do not match the permutation");
+            std::vector<T> internal(external.size());
+            for (Vertex v = 0; v < external.size(); v++) internal[to_internal(v)] = external[v];
+            return internal;
+        }
+
+        // A prev array in external ids, both its indices and its entries
+        std::vector<Vertex> external_tree(const std::vector<Vertex>& prev) const {
+            std::vector<Vertex> external = external_labels(prev);
+            for (Vertex& p : external) p = to_external(p);
+            return external;
+        }
+
+        std::vector<Vertex> external_path(std::vector<Vertex> path) const {
+            for (Vertex& v : path) v = to_external(v);
+            return path;
+        }
+};
+
+// Breadth-first order, one component after the other starting from their lowest id: neighbors get nearby
+// ids, so a search front reads dist/prev in runs instead of at random
+template <typename GRAPH>
+VertexPermutation bfs_order(const GRAPH& G) {
+    std::size_t n = G.num_vertices();
+    std::vector<Vertex> order;
+    order.reserve(n);
+    std::vector<char> seen(n, 0);
+    for (Vertex root = 0; root < n; root++) {
+        if (seen[root]) continue;
+        seen[root] = 1;
+        order.push_back(root);
+        for (std::size_t i = order.size() - 1; i < order.size(); i++) {
+            G.for_each_neighbor(order[i], [&](Vertex w, Weight) {
+                if (!seen[w]) {
+                    seen[w] = 1;
+                    order.push_back(w);
+                }
+            });
+        }
+    }
+    return VertexPermutation(std::move(order));
+}
+
+// Reverse Cuthill-McKee: per component, a breadth-first order from a pseudo-peripheral vertex that visits the
+// neighbors of each vertex by increasing degree, reversed at the end. Keeps the bandwidth of the adjacency
+// matrix small, so neighbor ids stay close together throughout.
+template <typename GRAPH>
+VertexPermutation reverse_cuthill_mckee_order(const GRAPH& G) {
+    std::size_t n = G.num_vertices();
+    std::vector<std::size_t> degree(n, 0);
+    for (Vertex v = 0; v < n; v++) {
+        G.for_each_neighbor(v, [&](Vertex, Weight) { degree[v]++; });
+    }
+
+    std::vector<Vertex> order;
+    order.reserve(n);
+    std::vector<std::uint32_t> mark(n, 0);
+    std::uint32_t stamp = 0;
+    std::vector<Vertex> level, neighbors;
+    // Breadth-first from 'start' over unplaced vertices; returns a vertex of least degree in the last level
+    auto farthest = [&](Vertex start) {
+        stamp++;
+        mark[start] = stamp;
+        level.assign(1, start);
+        std::vector<Vertex> next;
+        while (true) {
+            next.clear();
+            for (Vertex u : level) {
+                G.for_each_neighbor(u, [&](Vertex w, Weight) {
+                    if (mark[w] != stamp and mark[w] != 1) {
+                        mark[w] = stamp;
+                        next.push_back(w);
+                    }
+                });
+            }
+            if (next.empty()) break;
+            level.swap(next);
+        }
+        return *std::min_element(level.begin(), level.end(), [&](Vertex a, Vertex b) { return degree[a] < degree[b]; });
+    };
+
+    // mark == 1 means placed; the stamps of the peripheral sweeps start above it
+    stamp = 1;
+    for (Vertex root = 0; root < n; root++) {
+        if (mark[root] == 1) continue;
+        Vertex start = farthest(farthest(root));
+        std::size_t first = order.size();
+        mark[start] = 1;
+        order.push_back(start);
+        for (std::size_t i = first; i < order.size(); i++) {
+            neighbors.clear();
+            G.for_each_neighbor(order[i], [&](Vertex w, Weight) {
+                if (mark[w] != 1) {
+                    mark[w] = 1;
+                    neighbors.push_back(w);
+                }
+            });
+            std::sort(neighbors.begin(), neighbors.end(), [&](Vertex a, Vertex b) { return degree[a] < degree[b]; });
+            order.insert(order.end(), neighbors.begin(), neighbors.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return VertexPermutation(std::move(order));
+}
+
+// Position of (x, y) along a Hilbert curve filling a 2^bits x 2^bits grid
+inline std::uint64_t hilbert_index(std::uint32_t x, std::uint32_t y, unsigned bits) {
+    std::uint64_t d = 0;
+    for (std::uint32_t s = std::uint32_t(1) << (bits - 1); s > 0; s >>= 1) {
+        std::uint32_t rx = (x & s) > 0, ry = (y & s) > 0;
+        d += std::uint64_t(s) * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the curve continues where the last one ended
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - (x & (s - 1));
+                y = s - 1 - (y & (s - 1));
+            }
+            std::swap(x, y);
+        }
+        x &= s - 1;
+        y &= s - 1;
+    }
+    return d;
+}
+
+// Vertices sorted along a Hilbert curve through their bounding box: vertices close in the plane get close ids,
+// which for road-like graphs means neighbors do too, and unlike BFS the order does not depend on edges
+inline VertexPermutation hilbert_order(const std::vector<Coordinate>& coordinates, unsigned bits = 20) {
+    std::size_t n = coordinates.size();
+    double min_x = 1.0 / 0.0, min_y = 1.0 / 0.0, max_x = -1.0 / 0.0, max_y = -1.0 / 0.0;
+    for (const Coordinate& c : coordinates) {
+        min_x = std::min(min_x, c.x);
+        max_x = std::max(max_x, c.x);
+        min_y = std::min(min_y, c.y);
+        max_y = std::max(max_y, c.y);
+    }
+    double cells = double((std::uint64_t(1) << bits) - 1);
+    auto scaled = [&](double value, double low, double high) {
+        return high > low ? static_cast<std::uint32_t>((value - low) / (high - low) * cells) : 0u;
+    };
+    std::vector<std::uint64_t> key(n);
+    for (Vertex v = 0; v < n; v++) {
+        key[v] = hilbert_index(scaled(coordinates[v].x, min_x, max_x), scaled(coordinates[v].y, min_y, max_y), bits);
+    }
+    std::vector<Vertex> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](Vertex a, Vertex b) { return key[a] < key[b]; });
+    return VertexPermutation(std::move(order));
+}
+
+// A uniformly random order: the worst case for locality, as a baseline
+inline VertexPermutation random_order(std::size_t n, unsigned seed) {
+    std::vector<Vertex> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(seed));
+    return VertexPermutation(std::move(order));
+}
+
+// A copy of G with its vertices renumbered; keeps the vertex count even if the highest new ids are isolated
+inline Graph reorder(Graph& G, const VertexPermutation& permutation) {
+    if (permutation.size() != G.num_vertices()) throw std::runtime_error("Permutation does not match the graph");
+    return Graph(permutation.relabel(G.get_data()), G.num_vertices());
+}